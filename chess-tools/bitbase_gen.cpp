@@ -0,0 +1,292 @@
+//+++
+// 3駒の終盤 (KQK, KRK, KPK) のビットベースを作るプログラム
+// ・駒を持つ側 (白) が勝つ局面を、詰みの局面から後ろ向きに広げて求める (後退解析)
+//     白番: 白の手のどれかで「白の勝ちの黒番局面」に行ければ勝ち
+//     黒番: 黒の手が全て「白の勝ちの白番局面」に行く (合法手が無ければチェックされている) なら勝ち
+//   これを変化が無くなるまで繰り返し、最後まで勝ちにならなかった局面は引き分け
+// ・KPK のポーンの昇格はクイーンとルークを調べる (先に作った KQK, KRK の表を引く)
+//   ナイト・ビショップへの昇格は勝てないので調べなくてよい
+// ・出力は Bitbases (myapp/chess/bitbase.hpp) が読む形式 (ヘッダ8バイト + 1局面1bit)
+//
+// 使い方: bitbase_gen [出力ディレクトリ]
+//+++
+
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "bitbase.hpp"
+#include "bitboard.hpp"
+
+enum Result : std::uint8_t
+{
+    UNKNOWN,
+    WIN,
+    DRAW,
+    ILLEGAL
+};
+
+using Table = std::vector<Result>;
+
+static void decode(std::size_t idx, int &stm, int &wk, int &bk, int &psq)
+{
+    stm = int(idx >> 18);
+    wk = int((idx >> 12) & 63);
+    bk = int((idx >> 6) & 63);
+    psq = int(idx & 63);
+}
+
+// 白の駒 (キング以外) の利き
+static Bitboard pieceAttacks(int type, int sq, Bitboard occupied)
+{
+    switch (type)
+    {
+    case PAWN: return Attacks::pawn[WHITE][sq];
+    case ROOK: return Attacks::rook(sq, occupied);
+    default: return Attacks::queen(sq, occupied);
+    }
+}
+
+class Generator
+{
+public:
+    // promoteQueen / promoteRook: ポーンの昇格先の表 (KPK のみ)
+    Generator(int type, const Table *promoteQueen = nullptr, const Table *promoteRook = nullptr)
+        : type_(type), table_(Bitbases::POSITION_COUNT, UNKNOWN), promoteQueen_(promoteQueen), promoteRook_(promoteRook)
+    {
+    }
+
+    int run()
+    {
+        initialize();
+        int passes = 0;
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (std::size_t idx = 0; idx < table_.size(); idx++)
+            {
+                if (table_[idx] == UNKNOWN && isWin(idx))
+                {
+                    table_[idx] = WIN;
+                    changed = true;
+                }
+            }
+            passes++;
+        }
+        for (Result &r : table_)
+            if (r == UNKNOWN)
+                r = DRAW;
+        return passes;
+    }
+
+    const Table &table() const { return table_; }
+
+private:
+    // 駒の重なり・隣り合ったキング・手番でない側へのチェックなどの局面を除き、
+    // 黒番で合法手が無い局面 (チェックメイト・ステイルメイト) を決める
+    void initialize()
+    {
+        for (std::size_t idx = 0; idx < table_.size(); idx++)
+        {
+            int stm, wk, bk, psq;
+            decode(idx, stm, wk, bk, psq);
+            if (wk == bk || wk == psq || bk == psq || (Attacks::king[wk] & squareBB(bk)) ||
+                (type_ == PAWN && (rowOf(psq) == 0 || rowOf(psq) == 7)))
+            {
+                table_[idx] = ILLEGAL;
+                continue;
+            }
+
+            bool check = blackInCheck(wk, bk, psq);
+            if (stm == WHITE)
+            {
+                if (check)
+                    table_[idx] = ILLEGAL;
+            }
+            else if (blackMoves(wk, bk, psq) == 0)
+                table_[idx] = check ? WIN : DRAW;
+        }
+    }
+
+    bool blackInCheck(int wk, int bk, int psq) const
+    {
+        Bitboard occupied = squareBB(wk) | squareBB(bk) | squareBB(psq);
+        return pieceAttacks(type_, psq, occupied) & squareBB(bk);
+    }
+
+    // 黒キングの行き先 (白の駒を取る手を含む)
+    Bitboard blackMoves(int wk, int bk, int psq) const
+    {
+        Bitboard occupied = squareBB(wk) | squareBB(psq); // 黒キングは動くので遮らない
+        Bitboard targets = Attacks::king[bk] & ~Attacks::king[wk] & ~pieceAttacks(type_, psq, occupied);
+        return targets;
+    }
+
+    bool isWin(std::size_t idx) const
+    {
+        int stm, wk, bk, psq;
+        decode(idx, stm, wk, bk, psq);
+        return stm == WHITE ? whiteCanWin(wk, bk, psq) : blackMustLose(wk, bk, psq);
+    }
+
+    // 白番: どれかの手で勝ちの局面に行けるか
+    bool whiteCanWin(int wk, int bk, int psq) const
+    {
+        // キング
+        Bitboard b = Attacks::king[wk] & ~Attacks::king[bk] & ~squareBB(psq);
+        while (b)
+            if (table_[Bitbases::index(BLACK, popLsb(b), bk, psq)] == WIN)
+                return true;
+
+        if (type_ != PAWN)
+        {
+            Bitboard occupied = squareBB(wk) | squareBB(bk) | squareBB(psq);
+            b = pieceAttacks(type_, psq, occupied) & ~squareBB(wk) & ~squareBB(bk);
+            while (b)
+                if (table_[Bitbases::index(BLACK, wk, bk, popLsb(b))] == WIN)
+                    return true;
+            return false;
+        }
+
+        // ポーン (白は行番号の小さい方へ進む)
+        Bitboard occupied = squareBB(wk) | squareBB(bk);
+        int to = psq - 8;
+        if (occupied & squareBB(to))
+            return false;
+        if (rowOf(to) == 0)
+        {
+            std::size_t child = Bitbases::index(BLACK, wk, bk, to);
+            return (*promoteQueen_)[child] == WIN || (*promoteRook_)[child] == WIN;
+        }
+        if (table_[Bitbases::index(BLACK, wk, bk, to)] == WIN)
+            return true;
+        if (rowOf(psq) == 6 && !(occupied & squareBB(to - 8)) && table_[Bitbases::index(BLACK, wk, bk, to - 8)] == WIN)
+            return true;
+        return false;
+    }
+
+    // 黒番: 全ての手が負けの局面に行くか (白の駒を取れれば引き分け)
+    bool blackMustLose(int wk, int bk, int psq) const
+    {
+        Bitboard b = blackMoves(wk, bk, psq);
+        if (b & squareBB(psq))
+            return false;
+        while (b)
+            if (table_[Bitbases::index(WHITE, wk, popLsb(b), psq)] != WIN)
+                return false;
+        return true;
+    }
+
+    int type_;
+    Table table_;
+    const Table *promoteQueen_;
+    const Table *promoteRook_;
+};
+
+static bool writeBitbase(const std::string &path, int type, const Table &table)
+{
+    std::vector<unsigned char> data(Bitbases::FILE_SIZE, 0);
+    data[0] = 'M';
+    data[1] = 'K';
+    data[2] = 'B';
+    data[3] = 'B';
+    data[4] = Bitbases::VERSION;
+    data[5] = (unsigned char)type;
+    for (std::size_t idx = 0; idx < table.size(); idx++)
+        if (table[idx] == WIN)
+            data[Bitbases::HEADER_SIZE + (idx >> 3)] |= (unsigned char)(1 << (idx & 7));
+
+    std::ofstream out(path, std::ios::binary);
+    return out.write(reinterpret_cast<const char *>(data.data()), data.size()).good();
+}
+
+static bool generate(const std::string &dir, const char *name, Generator &gen, int type)
+{
+    auto start = std::chrono::steady_clock::now();
+    int passes = gen.run();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // 手番ごとの勝ち/引き分けの局面数
+    std::size_t wins[2] = {0, 0}, draws[2] = {0, 0};
+    for (std::size_t idx = 0; idx < gen.table().size(); idx++)
+    {
+        int stm = int(idx >> 18);
+        if (gen.table()[idx] == WIN)
+            wins[stm]++;
+        else if (gen.table()[idx] == DRAW)
+            draws[stm]++;
+    }
+
+    std::string path = dir + "/" + Bitbases::fileName(type);
+    bool ok = writeBitbase(path, type, gen.table());
+    std::printf("%s: %3d passes %8.1f ms  white to move %6zu win %6zu draw  black to move %6zu win %6zu draw  -> %s%s\n",
+                name, passes, ms, wins[WHITE], draws[WHITE], wins[BLACK], draws[BLACK], path.c_str(),
+                ok ? "" : " (write failed)");
+    return ok;
+}
+
+// 既知の局面で結果を確かめる (白が駒を持つ局面、手番側から見た結果)
+struct CheckPosition
+{
+    const char *name;
+    int type, stm, wk, bk, psq;
+    BitbaseResult expected;
+};
+
+static int verify(const std::string &dir)
+{
+    Bitbases bb;
+    if (bb.load(dir) != 3)
+    {
+        std::printf("failed to load bitbases from %s\n", dir.c_str());
+        return 1;
+    }
+
+    auto sq = [](const char *s) { return makeSquare(7 - (s[1] - '1'), s[0] - 'a'); };
+    const CheckPosition checks[] = {
+        {"KPK Ke6 Pe5 / Ke8, white to move", PAWN, WHITE, sq("e6"), sq("e8"), sq("e5"), BITBASE_WIN},
+        {"KPK Ke6 Pe5 / Ke8, black to move", PAWN, BLACK, sq("e6"), sq("e8"), sq("e5"), BITBASE_LOSS},
+        {"KPK Ke6 Pe7 / Ke8 (stalemate), black to move", PAWN, BLACK, sq("e6"), sq("e8"), sq("e7"), BITBASE_DRAW},
+        {"KPK Ke6 Pe7 / Ke8, white to move", PAWN, WHITE, sq("e6"), sq("e8"), sq("e7"), BITBASE_WIN},
+        {"KPK Ke5 Pe4 / Ke7 (opposition), black to move", PAWN, BLACK, sq("e5"), sq("e7"), sq("e4"), BITBASE_LOSS},
+        {"KPK rook pawn Kb6 Pa6 / Ka8, white to move", PAWN, WHITE, sq("b6"), sq("a8"), sq("a6"), BITBASE_DRAW},
+        {"KPK Kd6 Pd5 / Kd8, black to move", PAWN, BLACK, sq("d6"), sq("d8"), sq("d5"), BITBASE_LOSS},
+        {"KPK black king catches the pawn, black to move", PAWN, BLACK, sq("h1"), sq("b4"), sq("a4"), BITBASE_DRAW},
+        {"KRK rook en prise, black to move", ROOK, BLACK, sq("a1"), sq("e5"), sq("e4"), BITBASE_DRAW},
+        {"KRK Ka1 Rh1 / Ke5, white to move", ROOK, WHITE, sq("a1"), sq("e5"), sq("h1"), BITBASE_WIN},
+        {"KQK stalemate Kc7 Qb6 / Ka8, black to move", QUEEN, BLACK, sq("c7"), sq("a8"), sq("b6"), BITBASE_DRAW},
+        {"KQK mate Kc7 Qb7 / Ka8, black to move", QUEEN, BLACK, sq("c7"), sq("a8"), sq("b7"), BITBASE_LOSS},
+    };
+
+    int failures = 0;
+    for (const CheckPosition &c : checks)
+    {
+        BitbaseResult r = bb.probe(c.type, WHITE, c.stm, c.wk, c.bk, c.psq);
+        // 黒が駒を持つ場合 (上下反転) も同じ結果になること
+        BitbaseResult mirrored = bb.probe(c.type, BLACK, c.stm ^ 1, c.wk ^ 56, c.bk ^ 56, c.psq ^ 56);
+        bool ok = (r == c.expected && mirrored == c.expected);
+        failures += !ok;
+        std::printf("  %-50s %s\n", c.name, ok ? "OK" : "NG");
+    }
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    std::string dir = (argc > 1) ? argv[1] : ".";
+    Attacks::init();
+
+    Generator kqk(QUEEN);
+    Generator krk(ROOK);
+    bool ok = generate(dir, "KQK", kqk, QUEEN);
+    ok = generate(dir, "KRK", krk, ROOK) && ok;
+    Generator kpk(PAWN, &kqk.table(), &krk.table());
+    ok = generate(dir, "KPK", kpk, PAWN) && ok;
+    if (!ok)
+        return 1;
+    return verify(dir);
+}
@@ -0,0 +1,138 @@
+//+++
+// Polyglot のブックのキーの検証
+// ・乱数表 (Polyglot 標準の Random64) で計算した初期局面のキーが 463b96181691fc9c になること
+// ・Polyglot の仕様書のキーの例と一致することを、FEN から読んだ局面と指し進めた局面の両方で確かめる
+// ・ChessGame::bookKey のアンパサンの扱い (取れるポーンがいる時だけ列を入れる) が Polyglot と同じこと
+// ・初期局面のキー (他のプログラムで作ったブックと同じ値) で書いたブックを開いて引けること
+//
+// 使い方: book_check
+//+++
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "chess_game.hpp"
+
+static const char *START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+static const char *TEMP_BOOK = "book_check_tmp.bin";
+
+// Polyglot の仕様書 (book_format.html) のキーの例
+struct KeyVector
+{
+    const char *moves; // 初期局面からの手順 (nullptr = このエンジンでは指せない手を含むので FEN だけで確かめる)
+    const char *fen;
+    int epFile;        // キーに入れるアンパサンの列 (-1 = なし)
+    Key key;
+};
+
+static const KeyVector VECTORS[] = {
+    {"", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", -1, 0x463B96181691FC9CULL},
+    {"e2e4", "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1", -1, 0x823C9B50FD114196ULL},
+    {"e2e4 d7d5", "rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2", -1, 0x0756B94461C50FB0ULL},
+    {"e2e4 d7d5 e4e5", "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2", -1, 0x662FAFB965DB29D4ULL},
+    {"e2e4 d7d5 e4e5 f7f5", "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", 5,
+     0x22A48B5A8E47FF78ULL},
+    {"e2e4 d7d5 e4e5 f7f5 e1e2", "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3", -1,
+     0x652A607CA3F242C1ULL},
+    {"e2e4 d7d5 e4e5 f7f5 e1e2 e8f7", "rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4", -1,
+     0x00FDD303C946BDD9ULL},
+    {"a2a4 b7b5 h2h4 b5b4 c2c4", "rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3", 2,
+     0x3C8123EA7B067637ULL},
+    {nullptr, "rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4", -1, 0x5C3F9B829B279560ULL},
+};
+
+static bool report(const char *label, bool ok)
+{
+    std::printf("  %-64s %s\n", label, ok ? "OK" : "NG");
+    return ok;
+}
+
+static void writeBigEndian(std::ofstream &out, std::uint64_t value, int bytes)
+{
+    for (int i = bytes - 1; i >= 0; i--)
+        out.put(char((value >> (8 * i)) & 0xFF));
+}
+
+// key の手 (e2e4) が1つだけのブックを作る
+static void writeOneEntryBook(Key key)
+{
+    std::ofstream out(TEMP_BOOK, std::ios::binary);
+    writeBigEndian(out, key, 8);
+    writeBigEndian(out, PolyglotBook::encodeMove(makeSquare(6, 4), makeSquare(4, 4), PolyglotBook::NO_PIECE_TYPE), 2);
+    writeBigEndian(out, 1, 2);
+    writeBigEndian(out, 0, 4);
+}
+
+// ChessGame::bookKey が book.key (アンパサンの列を期待どおりに与えたもの) と一致するか
+static bool checkEnPassantRule(ChessGame &game, int epFile)
+{
+    FenPosition pos;
+    game.getPosition(pos);
+    return game.bookKey() == PolyglotBook::key(pos.board, pos.castling, epFile, pos.sideToMove == WHITE);
+}
+
+// 初期局面から moves を指す
+static bool playMoves(ChessGame &game, const char *moves)
+{
+    game.setFen(START_FEN);
+    std::istringstream is(moves);
+    std::string token;
+    while (is >> token)
+    {
+        PackedMove m;
+        if (!game.algebraicToMove(token, m))
+            return false;
+        game.makeMove(m.toMove());
+    }
+    return true;
+}
+
+int main()
+{
+    int failures = 0;
+    ChessGame game(1);
+    game.setBook(std::make_shared<PolyglotBook>()); // bookKey はブックがある時だけ計算する
+
+    std::printf("published keys:\n");
+    for (const KeyVector &v : VECTORS)
+    {
+        bool ok = game.setFen(v.fen) && game.bookKey() == v.key;
+        if (v.moves)
+            ok = ok && playMoves(game, v.moves) && game.bookKey() == v.key;
+        failures += !report(v.fen, ok);
+    }
+
+    std::printf("en passant file in the key:\n");
+    for (const KeyVector &v : VECTORS)
+    {
+        bool ok = game.setFen(v.fen) && checkEnPassantRule(game, v.epFile);
+        if (v.moves)
+            ok = ok && playMoves(game, v.moves) && checkEnPassantRule(game, v.epFile);
+        failures += !report(v.fen, ok);
+    }
+
+    // 他のプログラムで作ったブックと同じく、初期局面を STANDARD_START_KEY で書いたブックを引く
+    std::printf("book lookup:\n");
+    {
+        writeOneEntryBook(PolyglotBook::STANDARD_START_KEY);
+        auto book = std::make_shared<PolyglotBook>();
+        bool ok = book->open(TEMP_BOOK);
+        if (ok)
+        {
+            BookOptions options;
+            options.bestOnly = true;
+            game.setBook(book, options);
+            game.setFen(START_FEN);
+            PackedMove m = game.probeBook();
+            ok = !m.isNone() && game.moveToAlgebratic(m) == "e2e4";
+        }
+        failures += !report("start position entry is found", ok);
+        game.setBook(nullptr);
+    }
+    std::remove(TEMP_BOOK);
+
+    std::printf("%s\n", failures ? "book check FAILED" : "all book checks passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,200 @@
+//+++
+// オープニングブック (Polyglot 形式 .bin) の作成・確認ツール
+// ・build: 1行に1つの手順 ("e2e4 e7e5 g1f3 ...", 初期局面から) を書いたテキストからブックを作る
+//   同じ局面で同じ手が現れた回数を重みにする
+// ・probe: 局面 (省略時は初期局面) のブックの手と重みを表示し、1回の参照にかかる時間を測る
+// ・キーは Polyglot 標準の Random64 で計算するので、作ったブックは他のプログラムでも使え、
+//   他のプログラムで作った Polyglot のブックもそのまま引ける
+//
+// 使い方: book_tool build <out.bin> <lines.txt> [--max-ply N]
+//         book_tool probe <book.bin> ["<FEN>"]
+//+++
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "chess_game.hpp"
+
+static const char *START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+static void writeBigEndian(std::ofstream &out, std::uint64_t value, int bytes)
+{
+    for (int i = bytes - 1; i >= 0; i--)
+        out.put(char((value >> (8 * i)) & 0xFF));
+}
+
+// 探索用の指し手 -> Polyglot の指し手 (キャスリングはキングがルークのマスへ動く手)
+static std::uint16_t toPolyglotMove(PackedMove m)
+{
+    int to = m.to();
+    if (m.kind() == MOVE_CASTLING)
+        to = makeSquare(rowOf(m.from()), colOf(to) > colOf(m.from()) ? 7 : 0);
+    int promotion = (m.kind() == MOVE_PROMOTION) ? m.promotion() : PolyglotBook::NO_PIECE_TYPE;
+    return PolyglotBook::encodeMove(m.from(), to, promotion);
+}
+
+static int build(const std::string &outPath, const std::string &linesPath, std::shared_ptr<PolyglotBook> book, int maxPly)
+{
+    std::ifstream in(linesPath);
+    if (!in)
+    {
+        std::fprintf(stderr, "cannot open %s\n", linesPath.c_str());
+        return 1;
+    }
+
+    ChessGame game(1);
+    game.setBook(book); // bookKey はブックのキーの計算を使う
+
+    // (キー, 指し手) -> 現れた回数
+    std::map<std::pair<Key, std::uint16_t>, int> counts;
+    std::string line;
+    int lineNumber = 0, lines = 0;
+    while (std::getline(in, line))
+    {
+        lineNumber++;
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        game.setFen(START_FEN);
+        std::istringstream is(line);
+        std::string token;
+        for (int ply = 0; is >> token && ply < maxPly; ply++)
+        {
+            PackedMove m;
+            if (!game.algebraicToMove(token, m))
+            {
+                std::fprintf(stderr, "%s:%d: illegal move %s (ignored from here)\n", linesPath.c_str(), lineNumber,
+                             token.c_str());
+                break;
+            }
+            counts[{game.bookKey(), toPolyglotMove(m)}]++;
+            game.makeMove(m.toMove());
+        }
+        lines++;
+    }
+
+    // キー順 (同じキーの中では重い順) に並べる
+    std::vector<BookEntry> entries;
+    int maxCount = 1;
+    for (const auto &c : counts)
+        maxCount = std::max(maxCount, c.second);
+    for (const auto &c : counts)
+    {
+        BookEntry e;
+        e.key = c.first.first;
+        e.move = c.first.second;
+        // 重みは16bitに収まるように縮める
+        e.weight = std::uint16_t(std::max(1, int(std::int64_t(c.second) * 65535 / std::max(maxCount, 65535))));
+        entries.push_back(e);
+    }
+    std::sort(entries.begin(), entries.end(), [](const BookEntry &a, const BookEntry &b)
+              { return a.key != b.key ? a.key < b.key : a.weight > b.weight; });
+
+    std::ofstream out(outPath, std::ios::binary);
+    if (!out)
+    {
+        std::fprintf(stderr, "cannot write %s\n", outPath.c_str());
+        return 1;
+    }
+    for (const BookEntry &e : entries)
+    {
+        writeBigEndian(out, e.key, 8);
+        writeBigEndian(out, e.move, 2);
+        writeBigEndian(out, e.weight, 2);
+        writeBigEndian(out, e.learn, 4);
+    }
+    std::printf("%d lines, %zu entries -> %s\n", lines, entries.size(), outPath.c_str());
+    return 0;
+}
+
+static int probe(const std::string &bookPath, std::shared_ptr<PolyglotBook> book, const std::string &fen)
+{
+    if (!book->open(bookPath))
+    {
+        std::fprintf(stderr, "cannot open book %s\n", bookPath.c_str());
+        return 1;
+    }
+
+    ChessGame game(1);
+    if (!game.setFen(fen))
+    {
+        std::fprintf(stderr, "invalid FEN: %s\n", fen.c_str());
+        return 1;
+    }
+    BookOptions options;
+    options.maxPly = MAX_PLY * 16; // 手数で打ち切らない
+    game.setBook(book, options);
+
+    Key key = game.bookKey();
+    std::size_t first, last;
+    book->find(key, first, last);
+    std::printf("book: %s (%zu entries)\nkey: %016llx\n", bookPath.c_str(), book->entryCount(), (unsigned long long)key);
+
+    int total = 0;
+    for (std::size_t i = first; i < last; i++)
+        total += book->entry(i).weight;
+    for (std::size_t i = first; i < last; i++)
+    {
+        BookEntry e = book->entry(i);
+        int from, to, promotion;
+        PolyglotBook::decodeMove(e.move, from, to, promotion);
+        std::string move = game.coordsToAlgebraic(rowOf(from), colOf(from)) + game.coordsToAlgebraic(rowOf(to), colOf(to));
+        if (promotion != PolyglotBook::NO_PIECE_TYPE)
+            move += "nbrq"[promotion - KNIGHT];
+        std::printf("  %-6s weight %5u (%5.1f%%)\n", move.c_str(), e.weight, total ? 100.0 * e.weight / total : 0.0);
+    }
+    if (first == last)
+        std::printf("  (not in book)\n");
+
+    // 指し手生成 + キー計算 + 二分探索 + 合法手の確認 をまとめて測る
+    const int iterations = 100000;
+    int found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        found += !game.probeBook().isNone();
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    std::printf("probe: %.3f us/probe (%d/%d hits)\n", us / iterations, found, iterations);
+
+    PackedMove m = game.probeBook();
+    std::printf("pick: %s\n", m.isNone() ? "(none)" : game.moveToAlgebratic(m).c_str());
+    return 0;
+}
+
+static void usage()
+{
+    std::fprintf(stderr, "usage: book_tool build <out.bin> <lines.txt> [--max-ply N]\n"
+                         "       book_tool probe <book.bin> [\"<FEN>\"]\n");
+}
+
+int main(int argc, char **argv)
+{
+    int maxPly = 30;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!std::strcmp(argv[i], "--max-ply") && i + 1 < argc)
+            maxPly = std::atoi(argv[++i]);
+        else
+            args.push_back(argv[i]);
+    }
+
+    auto book = std::make_shared<PolyglotBook>();
+
+    if (args.size() == 3 && args[0] == "build")
+        return build(args[1], args[2], book, maxPly);
+    if ((args.size() == 2 || args.size() == 3) && args[0] == "probe")
+        return probe(args[1], book, args.size() == 3 ? args[2] : START_FEN);
+
+    usage();
+    return 1;
+}
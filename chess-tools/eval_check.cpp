@@ -0,0 +1,114 @@
+//+++
+// 評価関数の検証・ベンチマーク
+// ・差分更新版 (staticEvaluation) と盤面を毎回走査する従来版 (staticEvaluationFullScan) を
+//   ランダムに指し進めた局面で突き合わせる
+// ・途中で探索も走らせ、makeMoveInternal/unmakeMoveInternal で値が元に戻ることも確かめる
+// ・集めた局面で1秒あたりの評価回数を比較する
+//
+// 使い方: eval_check [局面数]
+//+++
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "chess_game.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+static std::uint64_t state = 0x2545F4914F6CDD1DULL;
+
+static std::uint64_t nextRand()
+{
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+}
+
+template <typename EvalFn>
+static double bench(const char *label, std::vector<ChessGame> &games, int iterations, EvalFn eval)
+{
+    auto start = Clock::now();
+    long long sum = 0;
+    for (int it = 0; it < iterations; it++)
+        for (const ChessGame &game : games)
+            sum += eval(game);
+    double sec = std::chrono::duration<double>(Clock::now() - start).count();
+    double evals = double(games.size()) * iterations;
+    std::printf("%-22s %10.0f evals  %8.3f s  %12.0f evals/s  (checksum %lld)\n", label, evals, sec, evals / sec, sum);
+    return evals / sec;
+}
+
+int main(int argc, char *argv[])
+{
+    int target = (argc > 1) ? std::atoi(argv[1]) : 100000;
+
+    const std::string starts[][8] = {
+        {"rnbqkbnr", "pppppppp", "********", "********", "********", "********", "PPPPPPPP", "RNBQKBNR"},
+        {"r***k**r", "p*ppqpb*", "bn**pnp*", "***PN***", "*p**P***", "**N**Q*p", "PPPBBPPP", "R***K**R"},
+        {"r**q*rk*", "pp**bppp", "**n*pn**", "**pp****", "***P****", "**PBPN**", "PP*N*PPP", "R*BQK**R"},
+    };
+
+    // 1. ランダムに指し進めながら突き合わせる
+    std::vector<ChessGame> samples;
+    int checked = 0, searches = 0;
+    ChessGame game(1);
+    while (checked < target)
+    {
+        game.initBoardWithStrings(starts[nextRand() % 3]);
+        bool white = true;
+        for (int ply = 0; ply < 200 && checked < target; ply++)
+        {
+            std::vector<Move> moves = game.generateMoves(white);
+            if (moves.empty())
+                break;
+
+            // 探索 (make/unmake) の後でも値が変わらないこと
+            if (nextRand() % 64 == 0)
+            {
+                int before = game.staticEvaluation();
+                SearchLimits limits;
+                limits.depth = 2;
+                game.bestMove(white, limits);
+                searches++;
+                if (game.staticEvaluation() != before)
+                {
+                    std::printf("MISMATCH after search: %d -> %d\n", before, game.staticEvaluation());
+                    return 1;
+                }
+            }
+
+            game.makeMove(moves[nextRand() % moves.size()]);
+            white = !white;
+
+            int fast = game.staticEvaluation();
+            int slow = game.staticEvaluationFullScan();
+            checked++;
+            if (fast != slow)
+            {
+                std::string rows[8];
+                game.getBoardAsStrings(rows);
+                std::printf("MISMATCH: incremental %d, full scan %d\n", fast, slow);
+                for (auto &row : rows)
+                    std::printf("  %s\n", row.c_str());
+                return 1;
+            }
+            if (samples.size() < 1024 && nextRand() % 8 == 0)
+                samples.push_back(game);
+        }
+    }
+    std::printf("all %d positions match (%d searches in between)\n", checked, searches);
+
+    // 2. 1秒あたりの評価回数
+    int iterations = 800;
+    double slow = bench("full scan (before)", samples, iterations / 10 + 1,
+                        [](const ChessGame &g) { return g.staticEvaluationFullScan(); });
+    double fast = bench("incremental (after)", samples, iterations,
+                        [](const ChessGame &g) { return g.staticEvaluation(); });
+    std::printf("speedup: %.1fx\n", fast / slow);
+    return 0;
+}
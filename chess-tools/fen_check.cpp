@@ -0,0 +1,202 @@
+//+++
+// FEN の読み書きの検証・ベンチマーク
+// ・全てのフィールドを持つ FEN を読んで書き出し、元と同じ文字列になることを確かめる
+// ・省略したフィールド・余分な空白は決まった形に直り、書式の誤りは読み込みで弾かれることを確かめる
+// ・ランダムに指し進めた局面を ChessGame::fen -> setFen で別のオブジェクトに移し、
+//   FEN・合法手・評価値が一致することを確かめる (アンパサンのマスと手数も引き継がれること)
+// ・parseFen / writeFen / ChessGame::setFen / ChessGame::fen の1回あたりの時間と、
+//   その間のヒープ確保の回数 (0であること) を表示する
+//
+// 使い方: fen_check
+//+++
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "chess_game.hpp"
+#include "fen.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// ヒープ確保を数える (計測区間の前後の差を見る)
+static std::atomic<std::uint64_t> allocations{0};
+
+void *operator new(std::size_t size)
+{
+    allocations++;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+static std::uint64_t state = 0x2545F4914F6CDD1DULL;
+
+static std::uint64_t nextRand()
+{
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+}
+
+// 読んで書き出すと expected になること (expected が nullptr なら読み込みで弾かれること)
+static bool checkFen(const char *fen, const char *expected)
+{
+    FenPosition pos;
+    FenBuffer buffer;
+    bool parsed = parseFen(fen, pos);
+    bool ok = expected ? (parsed && writeFen(pos, buffer) == expected) : !parsed;
+    std::printf("  %-72s %s\n", fen, ok ? "OK" : "NG");
+    if (!ok && parsed)
+        std::printf("    -> %s\n", buffer.c_str());
+    return ok;
+}
+
+// ランダムに指し進めながら、局面を FEN で別のオブジェクトに移して突き合わせる
+static int roundTripGames(int target)
+{
+    ChessGame game(1), copy(1);
+    int checked = 0, failures = 0, withEnPassant = 0;
+    while (checked < target)
+    {
+        game.setFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+        for (int ply = 0; ply < 200 && checked < target; ply++)
+        {
+            bool white = game.sideToMoveIsWhite();
+            std::vector<Move> moves = game.generateMoves(white);
+            if (moves.empty())
+                break;
+
+            FenBuffer original, copied;
+            std::string_view fen = game.fen(original);
+            bool ok = copy.setFen(fen) && copy.fen(copied) == fen && copy.sideToMoveIsWhite() == white &&
+                      copy.generateMoves(white) == moves && copy.staticEvaluation() == game.staticEvaluation() &&
+                      copy.gamePly() == game.gamePly();
+            FenPosition pos;
+            game.getPosition(pos);
+            withEnPassant += pos.epSquare != NO_SQUARE;
+            if (!ok && failures++ < 10)
+                std::printf("  MISMATCH %s\n           %s\n", original.c_str(), copied.c_str());
+            checked++;
+            game.makeMove(moves[nextRand() % moves.size()]);
+        }
+    }
+    std::printf("round-tripped %d positions through ChessGame (%d with an en passant square), %d mismatches\n",
+                checked, withEnPassant, failures);
+    return failures;
+}
+
+template <typename Fn>
+static void bench(const char *label, int iterations, Fn fn)
+{
+    std::uint64_t allocBefore = allocations;
+    auto start = Clock::now();
+    std::uint64_t sum = 0;
+    for (int i = 0; i < iterations; i++)
+        sum += fn(i);
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+    std::printf("%-20s %8.1f ns/call  %llu allocations  (checksum %llu)\n", label, ns,
+                (unsigned long long)(allocations - allocBefore), (unsigned long long)sum);
+}
+
+int main()
+{
+    const char *roundTrip[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1",
+        "rnbqkbnr/pp1ppppp/8/2p5/4P3/8/PPPP1PPP/RNBQKBNR w KQkq c6 0 2",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "4k3/8/8/8/8/8/8/4K2R b K - 99 123",
+        "8/8/8/8/8/8/8/K6k w - - 0 1",
+    };
+    const char *normalized[][2] = {
+        {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1"},
+        {"  4k3/8/8/8/8/8/8/4K3   b\tkq  ", "4k3/8/8/8/8/8/8/4K3 b kq - 0 1"},
+        {"4k3/8/8/8/8/8/8/4K3 w qkQK - 3 0", "4k3/8/8/8/8/8/8/4K3 w KQkq - 3 1"},
+        {"4k3/8/8/8/8/8/8/71 w - - 0 1", "4k3/8/8/8/8/8/8/8 w - - 0 1"},
+    };
+    const char *invalid[] = {
+        "",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP",                       // 7段しかない
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR/8 w - - 0 1",  // 9段
+        "rnbqkbnr/ppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1",     // 7マスの段
+        "rnbqkbnr/ppppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1",   // 9マスの段
+        "rnbqkbnr/pppppppp/9/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1",    // 9個の空マス
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNX w - - 0 1",    // 駒ではない文字
+        "rnbqkbnr/pppppppp/********/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1", // 手番
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkA - 0 1", // キャスリング権
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KK - 0 1",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq e3 0 1", // 白番なら6段目
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR b KQkq i3 0 1",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - x 1",  // 手数
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 -1",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 9999999999",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 bm e4", // 後ろに余分なもの
+    };
+
+    int failures = 0;
+    std::printf("round trip:\n");
+    for (const char *fen : roundTrip)
+        failures += !checkFen(fen, fen);
+    std::printf("normalized:\n");
+    for (const auto &c : normalized)
+        failures += !checkFen(c[0], c[1]);
+    std::printf("rejected:\n");
+    for (const char *fen : invalid)
+        failures += !checkFen(fen, nullptr);
+
+    // ChessGame で読み込むとキャスリング権はキングとルークの位置に合わせて落とされる
+    {
+        ChessGame game(1);
+        FenBuffer buffer;
+        bool ok = game.setFen("4k3/8/8/8/8/8/8/R3K3 w KQkq - 0 1") &&
+                  game.fen(buffer) == "4k3/8/8/8/8/8/8/R3K3 w Q - 0 1";
+        failures += !ok;
+        std::printf("  %-72s %s\n", "castling rights without the pieces are dropped", ok ? "OK" : "NG");
+    }
+
+    failures += roundTripGames(100000);
+
+    // 速度とヒープ確保の回数
+    std::vector<FenPosition> positions(1000);
+    std::vector<std::string> fens;
+    {
+        ChessGame game(1);
+        FenBuffer buffer;
+        for (FenPosition &pos : positions)
+        {
+            if (fens.size() % 100 == 0)
+                game.setFen(roundTrip[fens.size() / 100 % (sizeof(roundTrip) / sizeof(roundTrip[0]))]);
+            std::vector<Move> moves = game.generateMoves(game.sideToMoveIsWhite());
+            if (!moves.empty())
+                game.makeMove(moves[nextRand() % moves.size()]);
+            game.getPosition(pos);
+            fens.emplace_back(game.fen(buffer));
+        }
+    }
+    const int N = 1000000;
+    ChessGame game(1);
+    game.setFen(fens[0]); // キー履歴の領域などを先に確保しておく
+    FenPosition pos;
+    FenBuffer buffer;
+    bench("parseFen", N, [&](int i) { return parseFen(fens[i % fens.size()], pos) ? pos.fullmove : 0; });
+    bench("writeFen", N, [&](int i) { return writeFen(positions[i % positions.size()], buffer).size(); });
+    bench("ChessGame::setFen", N, [&](int i) { return game.setFen(fens[i % fens.size()]) ? 1 : 0; });
+    bench("ChessGame::fen", N, [&](int i) { return game.fen(buffer).size() + i % 2; });
+
+    std::printf("%s\n", failures ? "FEN check FAILED" : "all FEN checks passed");
+    return failures ? 1 : 0;
+}
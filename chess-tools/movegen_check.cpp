@@ -0,0 +1,305 @@
+//+++
+// 合法手生成の検証ツール
+// ・ChessGame::generateMoves (ピン/チェックのマスクによる合法手生成) と
+//   従来方式 (擬似合法手を生成 → 盤面をコピーして指し、自玉に利きが無いか確認) の
+//   参照実装を perft で全ノード突き合わせる
+// ・参照実装はこのファイル内で文字の盤面だけを使って独立に書いている
+//
+// 使い方: movegen_check [深さ]
+//+++
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "chess_game.hpp"
+
+// -------------------------------------------------------------
+// 参照実装 (文字の盤面 + キャスリング権)
+// -------------------------------------------------------------
+
+struct RefBoard
+{
+    char sq[8][8];
+    // [0] = 白, [1] = 黒
+    bool kingMoved[2] = {false, false};
+    bool rookQMoved[2] = {false, false};
+    bool rookKMoved[2] = {false, false};
+};
+
+static bool isWhitePiece(char p) { return p != '*' && std::isupper(p); }
+static bool onBoard(int r, int c) { return r >= 0 && r < 8 && c >= 0 && c < 8; }
+
+static bool refAttacked(const RefBoard &b, int r, int c, bool byWhite)
+{
+    auto is = [&](int rr, int cc, char upper)
+    {
+        if (!onBoard(rr, cc))
+            return false;
+        char p = b.sq[rr][cc];
+        return p != '*' && isWhitePiece(p) == byWhite && std::toupper(p) == upper;
+    };
+
+    const int knight[8][2] = {{2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}};
+    for (auto &d : knight)
+        if (is(r + d[0], c + d[1], 'N'))
+            return true;
+
+    for (int dr = -1; dr <= 1; dr++)
+        for (int dc = -1; dc <= 1; dc++)
+            if ((dr || dc) && is(r + dr, c + dc, 'K'))
+                return true;
+
+    int pr = r + (byWhite ? 1 : -1);
+    if (is(pr, c - 1, 'P') || is(pr, c + 1, 'P'))
+        return true;
+
+    const int dirs[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+    for (int i = 0; i < 8; i++)
+    {
+        int rr = r + dirs[i][0], cc = c + dirs[i][1];
+        while (onBoard(rr, cc))
+        {
+            char p = b.sq[rr][cc];
+            if (p != '*')
+            {
+                char u = std::toupper(p);
+                if (isWhitePiece(p) == byWhite && (u == 'Q' || u == (i < 4 ? 'R' : 'B')))
+                    return true;
+                break;
+            }
+            rr += dirs[i][0];
+            cc += dirs[i][1];
+        }
+    }
+    return false;
+}
+
+static void refMake(RefBoard &b, const Move &m)
+{
+    int r1 = m.first.first, c1 = m.first.second;
+    int r2 = m.second.first, c2 = m.second.second;
+    char p = b.sq[r1][c1];
+
+    if (std::toupper(p) == 'K' && std::abs(c2 - c1) == 2)
+    {
+        int rookFrom = (c2 > c1) ? 7 : 0, rookTo = (c2 > c1) ? 5 : 3;
+        b.sq[r1][rookTo] = b.sq[r1][rookFrom];
+        b.sq[r1][rookFrom] = '*';
+    }
+    b.sq[r2][c2] = p;
+    b.sq[r1][c1] = '*';
+    if (p == 'P' && r2 == 0)
+        b.sq[r2][c2] = 'Q';
+    if (p == 'p' && r2 == 7)
+        b.sq[r2][c2] = 'q';
+
+    for (auto sq : {m.first, m.second})
+    {
+        int color = (sq.first == 7) ? 0 : (sq.first == 0) ? 1 : -1;
+        if (color < 0)
+            continue;
+        if (sq.second == 4)
+            b.kingMoved[color] = true;
+        if (sq.second == 0)
+            b.rookQMoved[color] = true;
+        if (sq.second == 7)
+            b.rookKMoved[color] = true;
+    }
+}
+
+static std::vector<Move> refGenerate(const RefBoard &b, bool white)
+{
+    std::vector<Move> pseudo;
+    auto add = [&](int r, int c, int nr, int nc)
+    {
+        if (!onBoard(nr, nc))
+            return false;
+        char t = b.sq[nr][nc];
+        if (t != '*' && isWhitePiece(t) == white)
+            return false;
+        pseudo.push_back({{r, c}, {nr, nc}});
+        return t == '*';
+    };
+
+    for (int r = 0; r < 8; r++)
+    {
+        for (int c = 0; c < 8; c++)
+        {
+            char p = b.sq[r][c];
+            if (p == '*' || isWhitePiece(p) != white)
+                continue;
+            char u = std::toupper(p);
+            if (u == 'P')
+            {
+                int dir = white ? -1 : 1;
+                int nr = r + dir;
+                if (!onBoard(nr, c))
+                    continue;
+                if (b.sq[nr][c] == '*')
+                {
+                    pseudo.push_back({{r, c}, {nr, c}});
+                    bool initial = white ? r == 6 : r == 1;
+                    if (initial && b.sq[nr + dir][c] == '*')
+                        pseudo.push_back({{r, c}, {nr + dir, c}});
+                }
+                for (int nc : {c - 1, c + 1})
+                    if (onBoard(nr, nc) && b.sq[nr][nc] != '*' && isWhitePiece(b.sq[nr][nc]) != white)
+                        pseudo.push_back({{r, c}, {nr, nc}});
+            }
+            else if (u == 'N')
+            {
+                const int knight[8][2] = {{2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}};
+                for (auto &d : knight)
+                    add(r, c, r + d[0], c + d[1]);
+            }
+            else if (u == 'K')
+            {
+                for (int dr = -1; dr <= 1; dr++)
+                    for (int dc = -1; dc <= 1; dc++)
+                        if (dr || dc)
+                            add(r, c, r + dr, c + dc);
+
+                int color = white ? 0 : 1;
+                int rank = white ? 7 : 0;
+                char rook = white ? 'R' : 'r';
+                if (r == rank && c == 4 && !b.kingMoved[color] && !refAttacked(b, r, 4, !white))
+                {
+                    if (!b.rookKMoved[color] && b.sq[r][7] == rook && b.sq[r][5] == '*' && b.sq[r][6] == '*' &&
+                        !refAttacked(b, r, 5, !white))
+                        pseudo.push_back({{r, c}, {r, 6}});
+                    if (!b.rookQMoved[color] && b.sq[r][0] == rook && b.sq[r][1] == '*' && b.sq[r][2] == '*' &&
+                        b.sq[r][3] == '*' && !refAttacked(b, r, 3, !white))
+                        pseudo.push_back({{r, c}, {r, 2}});
+                }
+            }
+            else
+            {
+                const int dirs[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+                int from = (u == 'B') ? 4 : 0, to = (u == 'R') ? 4 : 8;
+                for (int i = from; i < to; i++)
+                    for (int k = 1; add(r, c, r + dirs[i][0] * k, c + dirs[i][1] * k); k++)
+                        ;
+            }
+        }
+    }
+
+    // 従来方式: 盤面をコピーして指し、自玉に利きが無い手だけを残す
+    std::vector<Move> legal;
+    char king = white ? 'K' : 'k';
+    for (const Move &m : pseudo)
+    {
+        RefBoard next = b;
+        refMake(next, m);
+        bool inCheck = false;
+        for (int r = 0; r < 8; r++)
+            for (int c = 0; c < 8; c++)
+                if (next.sq[r][c] == king && refAttacked(next, r, c, !white))
+                    inCheck = true;
+        if (!inCheck)
+            legal.push_back(m);
+    }
+    return legal;
+}
+
+// -------------------------------------------------------------
+// perft による突き合わせ
+// -------------------------------------------------------------
+
+static bool failed = false;
+
+static long long check(const ChessGame &game, const RefBoard &ref, bool white, int depth)
+{
+    std::vector<Move> moves = game.generateMoves(white);
+    std::vector<Move> expected = refGenerate(ref, white);
+    std::sort(moves.begin(), moves.end());
+    std::sort(expected.begin(), expected.end());
+
+    if (moves != expected)
+    {
+        failed = true;
+        std::string rows[8];
+        game.getBoardAsStrings(rows);
+        std::printf("MISMATCH (%s to move)\n", white ? "white" : "black");
+        for (auto &row : rows)
+            std::printf("  %s\n", row.c_str());
+        for (const Move &m : moves)
+            if (!std::binary_search(expected.begin(), expected.end(), m))
+                std::printf("  extra:   %s\n", game.moveToAlgebratic(m).c_str());
+        for (const Move &m : expected)
+            if (!std::binary_search(moves.begin(), moves.end(), m))
+                std::printf("  missing: %s\n", game.moveToAlgebratic(m).c_str());
+        return 0;
+    }
+
+    if (depth <= 1)
+        return (long long)moves.size();
+
+    long long nodes = 0;
+    for (const Move &m : moves)
+    {
+        ChessGame next = game;
+        next.makeMove(m);
+        RefBoard nextRef = ref;
+        refMake(nextRef, m);
+        nodes += check(next, nextRef, !white, depth - 1);
+        if (failed)
+            break;
+    }
+    return nodes;
+}
+
+struct TestPosition
+{
+    const char *name;
+    std::string rows[8];
+    bool white;
+};
+
+int main(int argc, char *argv[])
+{
+    int depth = (argc > 1) ? std::atoi(argv[1]) : 3;
+
+    // キャスリング権は initBoardWithStrings と同じく全て残っている前提
+    const TestPosition positions[] = {
+        {"startpos",
+         {"rnbqkbnr", "pppppppp", "********", "********", "********", "********", "PPPPPPPP", "RNBQKBNR"},
+         true},
+        {"kiwipete",
+         {"r***k**r", "p*ppqpb*", "bn**pnp*", "***PN***", "*p**P***", "**N**Q*p", "PPPBBPPP", "R***K**R"},
+         true},
+        {"rook endgame",
+         {"********", "**p*****", "***p****", "KP*****r", "*R***p*k", "********", "****P*P*", "********"},
+         true},
+        {"promotions",
+         {"r***k**r", "Pppp*ppp", "*b***nbN", "nP******", "BBP*P***", "q****N**", "Pp*P**PP", "R**Q*RK*"},
+         true},
+        {"pins and checks",
+         {"rnbq*k*r", "pp*Pbppp", "**p*****", "********", "**B*****", "********", "PPP*NnPP", "RNBQK**R"},
+         true},
+    };
+
+    long long total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const TestPosition &pos : positions)
+    {
+        ChessGame game;
+        game.initBoardWithStrings(pos.rows);
+        RefBoard ref;
+        for (int r = 0; r < 8; r++)
+            for (int c = 0; c < 8; c++)
+                ref.sq[r][c] = pos.rows[r][c];
+
+        long long nodes = check(game, ref, pos.white, depth);
+        std::printf("%-16s depth %d: %10lld nodes %s\n", pos.name, depth, nodes, failed ? "NG" : "OK");
+        if (failed)
+            return 1;
+        total += nodes;
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("all positions match (%lld nodes, %.2f s)\n", total, sec);
+    return 0;
+}
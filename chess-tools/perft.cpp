@@ -0,0 +1,192 @@
+//+++
+// perft (合法手の木の末端ノード数) の計測ツール
+// ・FENと深さを受け取り、ルートの手ごとのノード数 (divide)・合計・速度を表示する
+// ・ルートの手をスレッドに振り分けて数える (盤面はスレッドごとにコピー)
+// ・--hash を付けると、合流した局面のノード数をキャッシュして数え直さない
+// ・--bench は標準の検証局面をまとめて数え、このエンジンの手の集合でのノード数と比べる
+//   (一致しなければ終了コード 1)
+//   このエンジンはアンパサンとアンダープロモーション (クイーン以外への昇格) を生成しないので、
+//   公開されている値 (chessprogramming.org) とは一致しない。公開値は参考として並べて表示する
+//   (startpos の深さ5の差 258 は、公開値の内訳のアンパサンの数と同じ)
+//
+// 使い方: perft [--hash MB] [--threads N] "<FEN>" <深さ>
+//         perft [--hash MB] [--threads N] --bench
+//+++
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chess_game.hpp"
+
+struct PerftOptions
+{
+    int hashMB = 0; // 0 = キャッシュなし
+    int threads = 1;
+    bool divide = true;
+};
+
+struct PerftResult
+{
+    std::uint64_t nodes = 0;
+    double seconds = 0;
+};
+
+// ルートの手ごとに数える (手は threads 本のスレッドで取り合う)
+static PerftResult runPerft(const ChessGame &root, int depth, const PerftOptions &opt)
+{
+    bool white = root.sideToMoveIsWhite();
+    std::vector<Move> moves = root.generateMoves(white);
+    std::vector<std::uint64_t> counts(moves.size(), 0);
+    std::unique_ptr<PerftCache> cache;
+    if (opt.hashMB > 0)
+        cache = std::make_unique<PerftCache>(opt.hashMB);
+
+    auto start = std::chrono::steady_clock::now();
+
+    if (depth <= 1)
+    {
+        std::fill(counts.begin(), counts.end(), depth == 1 ? 1 : 0);
+    }
+    else
+    {
+        std::atomic<std::size_t> nextMove{0};
+        auto worker = [&]()
+        {
+            for (std::size_t i = nextMove++; i < moves.size(); i = nextMove++)
+            {
+                ChessGame game = root;
+                game.makeMove(moves[i]);
+                counts[i] = game.perft(!white, depth - 1, cache.get());
+            }
+        };
+
+        std::vector<std::thread> helpers;
+        for (int t = 1; t < opt.threads; t++)
+            helpers.emplace_back(worker);
+        worker();
+        for (std::thread &t : helpers)
+            t.join();
+    }
+
+    PerftResult result;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (depth <= 0)
+        result.nodes = 1;
+
+    for (std::size_t i = 0; i < moves.size(); i++)
+    {
+        if (opt.divide)
+            std::printf("%s: %llu\n", root.moveToAlgebratic(moves[i]).c_str(), (unsigned long long)counts[i]);
+        result.nodes += counts[i];
+    }
+    return result;
+}
+
+// -------------------------------------------------------------
+// 標準の検証局面 (https://www.chessprogramming.org/Perft_Results)
+// -------------------------------------------------------------
+
+struct BenchPosition
+{
+    const char *name;
+    const char *fen;
+    int depth;
+    std::uint64_t expected;  // このエンジンの手の集合 (アンパサン・アンダープロモーションなし) での値
+    std::uint64_t reference; // 公開されている値 (全ての手を生成した場合)
+};
+
+static const BenchPosition benchPositions[] = {
+    {"startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865351, 4865609},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4068217, 4085603},
+    {"position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 671300, 674624},
+    {"position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, 320639, 422333},
+    {"position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 1806790, 2103487},
+};
+
+static int runBench(PerftOptions opt)
+{
+    opt.divide = false;
+    std::printf("%-10s %5s %12s %12s %12s %10s %12s\n", "position", "depth", "nodes", "expected", "reference",
+                "time (s)", "nodes/s");
+
+    std::uint64_t totalNodes = 0;
+    double totalSeconds = 0;
+    int mismatches = 0;
+    for (const BenchPosition &pos : benchPositions)
+    {
+        ChessGame game(1);
+        game.setFen(pos.fen);
+        PerftResult r = runPerft(game, pos.depth, opt);
+        totalNodes += r.nodes;
+        totalSeconds += r.seconds;
+        if (r.nodes != pos.expected)
+            mismatches++;
+        std::printf("%-10s %5d %12llu %12llu %12llu %10.3f %12.0f%s\n", pos.name, pos.depth,
+                    (unsigned long long)r.nodes, (unsigned long long)pos.expected, (unsigned long long)pos.reference,
+                    r.seconds, r.nodes / r.seconds, r.nodes == pos.expected ? "" : "  MISMATCH");
+    }
+
+    std::printf("total: %llu nodes, %.3f s, %.0f nodes/s\n", (unsigned long long)totalNodes, totalSeconds,
+                totalNodes / totalSeconds);
+    if (mismatches)
+    {
+        std::printf("%d position(s) differ from the expected counts\n", mismatches);
+        return 1;
+    }
+    std::printf("all positions match (reference counts include en passant / underpromotion, which are not generated)\n");
+    return 0;
+}
+
+static void usage()
+{
+    std::fprintf(stderr, "usage: perft [--hash MB] [--threads N] \"<FEN>\" <depth>\n"
+                         "       perft [--hash MB] [--threads N] --bench\n");
+}
+
+int main(int argc, char **argv)
+{
+    PerftOptions opt;
+    bool bench = false;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!std::strcmp(argv[i], "--hash") && i + 1 < argc)
+            opt.hashMB = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--threads") && i + 1 < argc)
+            opt.threads = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--bench"))
+            bench = true;
+        else
+            args.push_back(argv[i]);
+    }
+
+    if (bench)
+        return runBench(opt);
+
+    if (args.size() != 2)
+    {
+        usage();
+        return 1;
+    }
+
+    ChessGame game(1);
+    if (!game.setFen(args[0]))
+    {
+        std::fprintf(stderr, "invalid FEN: %s\n", args[0].c_str());
+        return 1;
+    }
+
+    int depth = std::atoi(args[1].c_str());
+    PerftResult r = runPerft(game, depth, opt);
+    std::printf("\nnodes: %llu\ntime: %.3f s\nnodes/s: %.0f\n", (unsigned long long)r.nodes, r.seconds,
+                r.seconds > 0 ? r.nodes / r.seconds : 0.0);
+    return 0;
+}
@@ -0,0 +1,125 @@
+//+++
+// 静的交換評価 (SEE) の検証ツール
+// ・取り合いの結果が分かっている局面で ChessGame::staticExchange の値を確かめる
+//   (X-ray・キングでは取り返せない場合・昇格・途中でやめる方が良い場合など)
+// ・値は手番側から見た駒の損得 (P:200, N/B:300, R:500, Q:900)
+// ・探索で使う staticExchangeGe (閾値との比較だけを求める版) が、ランダムに指し進めた
+//   局面の全ての駒取りで staticExchange と食い違わないことも確かめる
+//
+// 使い方: see_check
+//+++
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "chess_game.hpp"
+
+struct SeeCase
+{
+    const char *name;
+    const char *fen;
+    const char *move;
+    int expected;
+};
+
+static std::uint64_t state = 0x2545F4914F6CDD1DULL;
+
+static std::uint64_t nextRand()
+{
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+}
+
+// staticExchangeGe(move, t) は t <= staticExchange(move) の時だけ true
+static bool thresholdsAgree(const ChessGame &game, PackedMove move, int value)
+{
+    return game.staticExchangeGe(move, value) && !game.staticExchangeGe(move, value + 1) &&
+           game.staticExchangeGe(move, value - 100) && !game.staticExchangeGe(move, value + 100);
+}
+
+// ランダムに指し進めた局面の駒を取る手で、2つの版を突き合わせる
+static int crossCheck(int target)
+{
+    const std::string start[8] = {"rnbqkbnr", "pppppppp", "********", "********",
+                                  "********", "********", "PPPPPPPP", "RNBQKBNR"};
+    std::string rows[8];
+    int checked = 0, failures = 0;
+    ChessGame game(1);
+    while (checked < target)
+    {
+        game.initBoardWithStrings(start);
+        bool white = true;
+        for (int ply = 0; ply < 200 && checked < target; ply++)
+        {
+            std::vector<Move> moves = game.generateMoves(white);
+            if (moves.empty())
+                break;
+            game.getBoardAsStrings(rows);
+            for (const Move &m : moves)
+            {
+                if (rows[m.second.first][m.second.second] == '*')
+                    continue;
+                PackedMove move = game.toPackedMove(m);
+                int value = game.staticExchange(move);
+                checked++;
+                if (!thresholdsAgree(game, move, value))
+                {
+                    if (failures++ < 10)
+                        std::printf("  MISMATCH %s see %d\n", game.moveToAlgebratic(move).c_str(), value);
+                }
+            }
+            game.makeMove(moves[nextRand() % moves.size()]);
+            white = !white;
+        }
+    }
+    std::printf("cross-checked %d captures, %d mismatches\n", checked, failures);
+    return failures;
+}
+
+int main()
+{
+    const int P = 200, N = 300, B = 300, R = 500, Q = 900;
+    const SeeCase cases[] = {
+        {"undefended pawn", "4k3/8/8/3p4/4P3/8/8/4K3 w - - 0 1", "e4d5", P},
+        {"pawn for pawn", "4k3/8/2p5/3p4/4P3/8/8/4K3 w - - 0 1", "e4d5", 0},
+        {"queen takes defended pawn", "4k3/8/2p5/3p4/8/8/3Q4/4K3 w - - 0 1", "d2d5", P - Q},
+        {"rook takes undefended pawn", "1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", "e1e5", P},
+        {"rook x-ray behind rook", "4k3/3r4/8/3p4/8/8/3R4/3RK3 w - - 0 1", "d2d5", P},
+        {"rook without x-ray support", "4k3/3r4/8/3p4/8/8/3R4/4K3 w - - 0 1", "d2d5", P - R},
+        {"king cannot recapture", "8/8/8/4k3/3p4/8/3R4/3RK3 w - - 0 1", "d2d4", P},
+        {"king recaptures", "8/8/8/4k3/3p4/8/3R4/4K3 w - - 0 1", "d2d4", P - R},
+        {"bishop behind moving pawn", "4k3/8/1b6/2p5/3P4/4B3/8/4K3 w - - 0 1", "d4c5", P},
+        {"knight into a long exchange", "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", "d3e5", P - N},
+        {"queen lost, recaptures do not help", "3qkb1r/rpp2pp1/p1np3p/4p2Q/5P2/1PPb4/P2NP1PP/R1BK1BNR w - - 0 1", "h5e5",
+         P - Q},
+        {"bishop takes knight, pawn recaptures", "4k3/8/4p3/3n4/8/8/6B1/4K3 w - - 0 1", "g2d5", N - B},
+        {"promotion with capture", "3r3k/4P3/8/8/8/8/8/4K3 w - - 0 1", "e7d8q", R + Q - P},
+        {"promotion, recaptured", "3rk3/4P3/8/8/8/8/8/4K3 w - - 0 1", "e7d8q", R - P},
+        {"black captures", "4k3/8/8/3q4/8/3P4/2P5/4K3 b - - 0 1", "d5d3", P - Q},
+        {"castling", "4k3/8/8/8/8/8/8/4K2R w K - 0 1", "e1g1", 0},
+    };
+
+    int failures = 0;
+    for (const SeeCase &c : cases)
+    {
+        ChessGame game(1);
+        PackedMove move;
+        if (!game.setFen(c.fen) || !game.algebraicToMove(c.move, move))
+        {
+            std::printf("  %-40s %s  invalid position or move\n", c.name, c.move);
+            failures++;
+            continue;
+        }
+        int value = game.staticExchange(move);
+        bool ok = (value == c.expected) && thresholdsAgree(game, move, value);
+        failures += !ok;
+        std::printf("  %-40s %-6s %6d (expected %6d)  %s\n", c.name, c.move, value, c.expected, ok ? "OK" : "NG");
+    }
+    failures += crossCheck(200000);
+    std::printf("%s\n", failures ? "SEE check FAILED" : "all SEE checks passed");
+    return failures ? 1 : 0;
+}
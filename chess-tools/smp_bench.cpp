@@ -0,0 +1,79 @@
+//+++
+// 並列探索 (Lazy SMP) のベンチマーク
+// ・スレッド数 1, 2, 4, 8, 16 でそれぞれ同じ局面を決まった深さまで読み、
+//   深さに達するまでの時間 (time-to-depth) と1秒あたりのノード数を表示する
+// ・置換表は毎回作り直す (前の計測の結果を引き継がないように)
+// ・置換表のヒット率と、別の局面のエントリを追い出した割合 (書き込みに対して) も全スレッドの合計で表示する
+//
+// 使い方: smp_bench [深さ] [置換表MB] [最大スレッド数]
+//+++
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "chess_game.hpp"
+
+struct BenchPosition
+{
+    const char *name;
+    std::string rows[8];
+    bool white;
+};
+
+int main(int argc, char *argv[])
+{
+    int depth = (argc > 1) ? std::atoi(argv[1]) : 8;
+    int hashMB = (argc > 2) ? std::atoi(argv[2]) : 64;
+    int maxThreads = (argc > 3) ? std::atoi(argv[3]) : 16;
+
+    const BenchPosition positions[] = {
+        {"startpos",
+         {"rnbqkbnr", "pppppppp", "********", "********", "********", "********", "PPPPPPPP", "RNBQKBNR"},
+         true},
+        {"middlegame",
+         {"r*bq*rk*", "pp**bppp", "**n*pn**", "**pp****", "***P****", "**PBPN**", "PP*N*PPP", "R*BQK**R"},
+         true},
+        {"kiwipete",
+         {"r***k**r", "p*ppqpb*", "bn**pnp*", "***PN***", "*p**P***", "**N**Q*p", "PPPBBPPP", "R***K**R"},
+         true},
+    };
+
+    std::printf("depth %d, hash %d MB\n", depth, hashMB);
+    std::printf("%-8s %12s %14s %12s %8s %10s %8s %10s\n", "threads", "time (ms)", "nodes", "nodes/s", "speedup",
+                "pawn hit", "tt hit", "tt evict");
+
+    double baseTime = 0;
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        double totalMs = 0;
+        unsigned long long totalNodes = 0;
+        unsigned long long pawnProbes = 0, pawnHits = 0;
+        TranspositionTable::Stats tt;
+        for (const BenchPosition &pos : positions)
+        {
+            ChessGame game(hashMB);
+            game.setThreads(threads);
+            game.initBoardWithStrings(pos.rows);
+
+            SearchLimits limits;
+            limits.depth = depth;
+            game.bestMove(pos.white, limits);
+
+            totalMs += game.lastSearch().timeMs;
+            totalNodes += game.lastSearch().nodes;
+            pawnProbes += game.lastSearch().pawnProbes;
+            pawnHits += game.lastSearch().pawnHits;
+            tt += game.lastSearch().tt;
+        }
+
+        if (threads == 1)
+            baseTime = totalMs;
+        std::printf("%-8d %12.1f %14llu %12.0f %7.2fx %9.1f%% %7.1f%% %9.1f%%\n", threads, totalMs, totalNodes,
+                    totalNodes / (totalMs / 1000.0), baseTime / totalMs,
+                    pawnProbes ? 100.0 * pawnHits / pawnProbes : 0.0,
+                    tt.probes ? 100.0 * tt.hits / tt.probes : 0.0,
+                    tt.stores ? 100.0 * tt.collisions / tt.stores : 0.0);
+    }
+    return 0;
+}
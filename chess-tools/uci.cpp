@@ -0,0 +1,366 @@
+//+++
+// UCI (Universal Chess Interface) で ChessGame を動かすコンソールプログラム
+// ・他のエンジンとの対局や、GUIを使わない自動対局・ベンチマーク用
+// ・対応コマンド: uci / isready / ucinewgame /
+//   setoption (Hash, Threads, MultiPV, OwnBook, BookFile, BitbasePath) /
+//   position [startpos | fen ...] [moves ...] /
+//   go [depth | nodes | movetime | wtime | btime | winc | binc | movestogo | infinite | ponder] /
+//   stop / ponderhit / quit
+// ・アンパサンと、クイーン以外への昇格 (アンダープロモーション) には対応していない
+//   position の moves にこれらの手 (や不正な手) があると局面を再現できないので、
+//   次に position で局面を正しく指定されるまで go には bestmove 0000 を返す
+// ・探索は別スレッドで行い、stop はすぐに止める
+//+++
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "chess_game.hpp"
+
+static const char *START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+class UciEngine
+{
+public:
+    UciEngine()
+    {
+        game_.setFen(START_FEN);
+        // ビルドディレクトリで起動した場合は、ビルド時に作ったビットベースを使う
+        game_.loadBitbases("bitbases");
+    }
+
+    ~UciEngine() { stop(); }
+
+    // 1行分のコマンドを処理する (quit なら false)
+    bool command(const std::string &line)
+    {
+        std::istringstream is(line);
+        std::string token;
+        is >> token;
+
+        if (token == "uci")
+        {
+            send("id name mekatoro-chess");
+            send("id author mekatoro25-g10");
+            send("option name Hash type spin default 16 min 1 max 4096");
+            send("option name Threads type spin default 1 min 1 max 64");
+            send("option name Ponder type check default false");
+            send("option name MultiPV type spin default 1 min 1 max 256");
+            send("option name OwnBook type check default false");
+            send("option name BookFile type string default <empty>");
+            send("option name BitbasePath type string default bitbases");
+            send("uciok");
+        }
+        else if (token == "isready")
+            send("readyok");
+        else if (token == "ucinewgame")
+        {
+            stop();
+            game_.transpositionTable().clear();
+        }
+        else if (token == "setoption")
+            setOption(is);
+        else if (token == "position")
+        {
+            stop();
+            position(is);
+        }
+        else if (token == "go")
+        {
+            stop();
+            go(is);
+        }
+        else if (token == "stop")
+            stop();
+        else if (token == "ponderhit")
+            ponderHit();
+        else if (token == "quit")
+            return false;
+        return true;
+    }
+
+private:
+    // 標準出力は探索スレッドからも書くので、1行ずつまとめて書く
+    void send(const std::string &line)
+    {
+        std::lock_guard<std::mutex> lock(outputMutex_);
+        std::cout << line << std::endl;
+    }
+
+    void setOption(std::istringstream &is)
+    {
+        std::string token, name, value;
+        is >> token; // "name"
+        while (is >> token && token != "value")
+            name += (name.empty() ? "" : " ") + token;
+        std::getline(is >> std::ws, value); // ファイル名は空白を含んでもよい
+
+        stop();
+        if (name == "Hash")
+            game_.transpositionTable().resize(std::max(1, std::atoi(value.c_str())));
+        else if (name == "Threads")
+            game_.setThreads(std::atoi(value.c_str()));
+        else if (name == "MultiPV")
+            multiPv_ = std::max(1, std::atoi(value.c_str()));
+        else if (name == "OwnBook")
+        {
+            ownBook_ = (value == "true");
+            updateBook();
+        }
+        else if (name == "BookFile")
+        {
+            bookFile_ = (value == "<empty>") ? "" : value;
+            updateBook();
+        }
+        else if (name == "BitbasePath")
+        {
+            int loaded = game_.loadBitbases(value);
+            send("info string " + std::to_string(loaded) + " bitbase file(s) loaded from " + value);
+        }
+    }
+
+    // OwnBook が有効でファイルが指定されていればブックを開く
+    void updateBook()
+    {
+        // 持ち時間は GUI 側が管理するので、ブックで浮いた時間は貯めない (残り時間が増えるだけ)
+        BookOptions options;
+        options.bankTime = false;
+
+        if (!ownBook_ || bookFile_.empty())
+        {
+            game_.setBook(nullptr, options);
+            return;
+        }
+
+        auto book = std::make_shared<PolyglotBook>();
+        if (!book->open(bookFile_))
+        {
+            send("info string cannot open book: " + bookFile_);
+            book.reset();
+        }
+        game_.setBook(book, options);
+    }
+
+    void position(std::istringstream &is)
+    {
+        std::string token, fen;
+        is >> token;
+        if (token == "startpos")
+        {
+            fen = START_FEN;
+            is >> token; // "moves"
+        }
+        else if (token == "fen")
+        {
+            while (is >> token && token != "moves")
+                fen += token + " ";
+        }
+        else
+        {
+            send("info string unknown position: " + token);
+            desynced_ = true;
+            return;
+        }
+
+        if (!game_.setFen(fen))
+        {
+            send("info string invalid fen: " + fen);
+            desynced_ = true;
+            return;
+        }
+
+        // 指せない手 (不正な手、アンパサン、アンダープロモーション) が来たら、
+        // 途中の局面で読むと GUI と違う局面の手を返すことになるので、局面が分からないことにする
+        desynced_ = false;
+        while (is >> token)
+        {
+            PackedMove m;
+            if (!game_.algebraicToMove(token, m))
+            {
+                send("info string unsupported or illegal move: " + token);
+                desynced_ = true;
+                return;
+            }
+            game_.makeMove(m.toMove());
+        }
+    }
+
+    void go(std::istringstream &is)
+    {
+        if (desynced_)
+        {
+            send("info string position is unknown, send a new position command");
+            send("bestmove 0000");
+            return;
+        }
+
+        SearchLimits limits;
+        int time[2] = {0, 0}, inc[2] = {0, 0};
+        int movesToGo = 0;
+        bool infinite = false, ponder = false;
+
+        std::string token;
+        while (is >> token)
+        {
+            if (token == "depth")
+                is >> limits.depth;
+            else if (token == "nodes")
+                is >> limits.nodes;
+            else if (token == "movetime")
+                is >> limits.timeMs;
+            else if (token == "wtime")
+                is >> time[WHITE];
+            else if (token == "btime")
+                is >> time[BLACK];
+            else if (token == "winc")
+                is >> inc[WHITE];
+            else if (token == "binc")
+                is >> inc[BLACK];
+            else if (token == "movestogo")
+                is >> movesToGo;
+            else if (token == "infinite")
+                infinite = true;
+            else if (token == "ponder")
+                ponder = true;
+        }
+
+        bool white = game_.sideToMoveIsWhite();
+        int us = white ? WHITE : BLACK;
+        if (limits.timeMs == 0 && time[us] > 0)
+            limits.timeMs = allocateTime(time[us], inc[us], movesToGo);
+
+        // ponder 中は ponderhit まで時間で止めずに読み続ける
+        // (先読みしていた時間も思考時間に数えるので、ponderhit の時点で使い切っていればすぐ指す)
+        limits.ponder = ponder;
+        limits.multiPv = multiPv_;
+
+        {
+            std::lock_guard<std::mutex> lock(stateMutex_);
+            waitForStop_ = infinite || ponder;
+            stopRequested_ = false;
+        }
+        lastPv_.clear();
+
+        // 探索は盤面のコピーで行う (先読みの状態は探索スレッドが動き出す前に決まるので、
+        // go の直後に ponderhit が来ても取りこぼさない)
+        SearchCallbacks callbacks;
+        callbacks.onInfo = [this](const SearchInfo &info) { printInfo(info); };
+        callbacks.onDone = [this](const Move &best, const SearchStats &)
+        {
+            // infinite / ponder では stop (か ponderhit) が来るまで bestmove を返さない
+            {
+                std::unique_lock<std::mutex> lock(stateMutex_);
+                stateChanged_.wait(lock, [this]() { return !waitForStop_ || stopRequested_; });
+            }
+            sendBestMove(best);
+        };
+        search_ = game_.startSearch(white, limits, callbacks);
+    }
+
+    // 1手に使う時間 (残り時間を残りの手数で割り、加算時間の大半を足す)
+    static int allocateTime(int timeLeft, int increment, int movesToGo)
+    {
+        int moves = movesToGo > 0 ? movesToGo : 30;
+        int t = timeLeft / moves + increment * 3 / 4;
+        // 通信の遅れを見込んで、残り時間を使い切らないようにする
+        t = std::min(t, timeLeft - 50);
+        return std::max(t, 10);
+    }
+
+    void ponderHit()
+    {
+        // 相手が予想どおりに指したので、持ち時間で止める通常の探索に切り替える
+        search_.ponderHit();
+        {
+            std::lock_guard<std::mutex> lock(stateMutex_);
+            waitForStop_ = false;
+        }
+        stateChanged_.notify_all();
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(stateMutex_);
+            stopRequested_ = true;
+        }
+        stateChanged_.notify_all();
+        search_.stop();
+        search_.wait();
+    }
+
+    void sendBestMove(const Move &best)
+    {
+        if (best.first == best.second)
+        {
+            send("bestmove 0000");
+            return;
+        }
+
+        std::string move = game_.moveToAlgebratic(game_.toPackedMove(best));
+        std::string line = "bestmove " + move;
+        // 同点の手から選んだ場合は最善手順と違う手になるので、予想手は付けない
+        if (lastPv_.size() >= 2 && lastPv_[0] == move)
+            line += " ponder " + lastPv_[1];
+        send(line);
+    }
+
+    void printInfo(const SearchInfo &info)
+    {
+        // UCI の評価値は手番側から見た値
+        bool white = game_.sideToMoveIsWhite();
+        std::string score;
+        if (info.mateIn != 0)
+            score = "mate " + std::to_string(white ? info.mateIn : -info.mateIn);
+        else
+            score = "cp " + std::to_string(white ? info.score : -info.score);
+
+        std::string line = "info depth " + std::to_string(info.depth) +
+                           " seldepth " + std::to_string(info.selDepth) +
+                           " multipv " + std::to_string(info.multiPv) +
+                           " score " + score +
+                           " nodes " + std::to_string(info.nodes) +
+                           " nps " + std::to_string((unsigned long long)info.nps) +
+                           " hashfull " + std::to_string(info.hashfull) +
+                           " time " + std::to_string((long long)info.timeMs) + " pv";
+        for (const std::string &m : info.pv)
+            line += " " + m;
+        send(line);
+        if (info.multiPv == 1)
+            lastPv_ = info.pv;
+    }
+
+    ChessGame game_;
+    SearchHandle search_; // 実行中の探索
+    std::vector<std::string> lastPv_; // 探索スレッドだけが書く
+
+    std::mutex outputMutex_;
+    std::mutex stateMutex_;
+    std::condition_variable stateChanged_;
+    bool waitForStop_ = false;   // bestmove を stop/ponderhit まで待たせるか
+    bool stopRequested_ = false;
+    bool desynced_ = false;      // 最後の position の局面を再現できなかった (go には bestmove 0000 を返す)
+
+    int multiPv_ = 1;            // 候補手の数 (MultiPV)
+    bool ownBook_ = false;
+    std::string bookFile_;
+};
+
+int main()
+{
+    UciEngine engine;
+    std::string line;
+    while (std::getline(std::cin, line))
+    {
+        if (!engine.command(line))
+            break;
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include "bitbase.hpp"
+
+#include "bitboard.hpp"
+
+// -------------------------------------------------------------
+// Bitbases
+// -------------------------------------------------------------
+
+int Bitbases::slot(int pieceType)
+{
+    switch (pieceType)
+    {
+    case PAWN: return 0;
+    case ROOK: return 1;
+    case QUEEN: return 2;
+    default: return -1;
+    }
+}
+
+std::string Bitbases::fileName(int pieceType)
+{
+    switch (pieceType)
+    {
+    case PAWN: return "kpk.bb";
+    case ROOK: return "krk.bb";
+    case QUEEN: return "kqk.bb";
+    default: return "";
+    }
+}
+
+int Bitbases::load(const std::string &dir)
+{
+    int loaded = 0;
+    const int types[3] = {PAWN, ROOK, QUEEN};
+    for (int type : types)
+    {
+        int i = slot(type);
+        bits_[i] = nullptr;
+        std::string path = dir.empty() ? fileName(type) : dir + "/" + fileName(type);
+        if (!files_[i].open(path, MappedFile::ACCESS_RANDOM))
+            continue;
+
+        // ヘッダを確かめる (別の版・別の終盤のファイルは使わない)
+        const unsigned char *p = files_[i].data();
+        if (files_[i].size() != FILE_SIZE || p[0] != 'M' || p[1] != 'K' || p[2] != 'B' || p[3] != 'B' ||
+            p[4] != VERSION || p[5] != type)
+        {
+            files_[i].close();
+            continue;
+        }
+        bits_[i] = p + HEADER_SIZE;
+        loaded++;
+    }
+    return loaded;
+}
+
+bool Bitbases::has(int pieceType) const
+{
+    int i = slot(pieceType);
+    return i >= 0 && bits_[i] != nullptr;
+}
+
+BitbaseResult Bitbases::probe(int pieceType, int strongColor, int sideToMove, int strongKing, int weakKing,
+                              int pieceSq) const
+{
+    int i = slot(pieceType);
+    if (i < 0 || !bits_[i])
+        return BITBASE_UNKNOWN;
+
+    // 駒を持つ側が黒なら、盤面を上下反転して白の局面にする (ポーンの進む向きもそろう)
+    int stm = sideToMove;
+    if (strongColor == BLACK)
+    {
+        strongKing ^= 56;
+        weakKing ^= 56;
+        pieceSq ^= 56;
+        stm ^= 1;
+    }
+
+    std::size_t idx = index(stm, strongKing, weakKing, pieceSq);
+    if (!(bits_[i][idx >> 3] & (1 << (idx & 7))))
+        return BITBASE_DRAW;
+    return (sideToMove == strongColor) ? BITBASE_WIN : BITBASE_LOSS;
+}
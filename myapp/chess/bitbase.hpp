@@ -0,0 +1,60 @@
+#pragma once
+
+//+++
+// 3駒の終盤 (KPK, KRK, KQK) のビットベース
+// ・キング2つ + 1駒の全局面について、駒を持つ側が勝ちかどうかを1bitで持つ
+//   (3駒では駒を持たない側は勝てないので、勝ち/引き分けの区別だけでよい)
+// ・ファイルは chess-tools の bitbase_gen が後退解析で作る (kpk.bb, krk.bb, kqk.bb)
+//   ここでは開いたファイルをメモリマップして引くだけなので、読み込みに時間はかからない
+// ・添字は駒を持つ側を白にそろえて (黒なら盤面を上下反転して) 計算する
+//   [手番 2][強い側のキング 64][弱い側のキング 64][駒 64] = 2^19 局面 = 64KB
+//+++
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "mapped_file.hpp"
+
+// 手番側から見た結果
+enum BitbaseResult
+{
+    BITBASE_UNKNOWN = -2, // ビットベースが無い局面
+    BITBASE_LOSS = -1,
+    BITBASE_DRAW = 0,
+    BITBASE_WIN = 1
+};
+
+class Bitbases
+{
+public:
+    static constexpr std::size_t POSITION_COUNT = 2 * 64 * 64 * 64;
+    static constexpr std::size_t HEADER_SIZE = 8; // "MKBB", 版, 駒種, 予約 x2
+    static constexpr std::size_t FILE_SIZE = HEADER_SIZE + POSITION_COUNT / 8;
+    static constexpr unsigned char VERSION = 1;
+
+    // dir にある kpk.bb, krk.bb, kqk.bb を開く (読み込めたファイル数を返す)
+    int load(const std::string &dir);
+
+    // pieceType (PAWN, ROOK, QUEEN) の終盤を持っているか
+    bool has(int pieceType) const;
+
+    // 局面を引く (マスは makeSquare の番号、手番は WHITE/BLACK)
+    // strongColor: 3つ目の駒を持つ側
+    BitbaseResult probe(int pieceType, int strongColor, int sideToMove, int strongKing, int weakKing, int pieceSq) const;
+
+    // 駒を持つ側を白にそろえた局面の添字 (生成プログラムと共通)
+    static std::size_t index(int sideToMove, int whiteKing, int blackKing, int pieceSq)
+    {
+        return (std::size_t(sideToMove) << 18) | (std::size_t(whiteKing) << 12) | (std::size_t(blackKing) << 6) |
+               std::size_t(pieceSq);
+    }
+
+    static std::string fileName(int pieceType); // "kpk.bb" など
+
+private:
+    static int slot(int pieceType); // PAWN, ROOK, QUEEN -> 0, 1, 2 (それ以外は -1)
+
+    MappedFile files_[3];
+    const unsigned char *bits_[3] = {nullptr, nullptr, nullptr};
+};
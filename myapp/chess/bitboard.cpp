@@ -0,0 +1,206 @@
+#include "bitboard.hpp"
+
+// -------------------------------------------------------------
+// 駒コード <-> 文字
+// -------------------------------------------------------------
+
+static const char PIECE_CHARS[] = "PNBRQKpnbrqk*";
+
+char pieceToChar(int piece)
+{
+    return PIECE_CHARS[piece];
+}
+
+int charToPiece(char c)
+{
+    for (int i = 0; i < NO_PIECE; i++)
+    {
+        if (PIECE_CHARS[i] == c)
+            return i;
+    }
+    return NO_PIECE;
+}
+
+// -------------------------------------------------------------
+// 利きテーブル
+// -------------------------------------------------------------
+
+namespace Attacks
+{
+    Bitboard knight[64];
+    Bitboard king[64];
+    Bitboard pawn[2][64];
+    Bitboard betweenBB[64][64];
+    Bitboard lineBB[64][64];
+
+    // (dr, dc) 方向に1歩進んだマスが盤内ならそのビットを返す
+    static Bitboard stepBB(int sq, int dr, int dc)
+    {
+        int r = rowOf(sq) + dr, c = colOf(sq) + dc;
+        if (r < 0 || r > 7 || c < 0 || c > 7)
+            return 0;
+        return squareBB(makeSquare(r, c));
+    }
+
+    // 1方向ずつ駒に当たるまで伸ばす
+    static Bitboard rayAttacks(int sq, Bitboard occupied, const int dirs[4][2])
+    {
+        Bitboard attacks = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            int r = rowOf(sq) + dirs[i][0], c = colOf(sq) + dirs[i][1];
+            while (r >= 0 && r < 8 && c >= 0 && c < 8)
+            {
+                Bitboard b = squareBB(makeSquare(r, c));
+                attacks |= b;
+                if (occupied & b)
+                    break;
+                r += dirs[i][0];
+                c += dirs[i][1];
+            }
+        }
+        return attacks;
+    }
+
+    static const int ROOK_DIRS[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    static const int BISHOP_DIRS[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+    Bitboard rookSlow(int sq, Bitboard occupied)
+    {
+        return rayAttacks(sq, occupied, ROOK_DIRS);
+    }
+
+    Bitboard bishopSlow(int sq, Bitboard occupied)
+    {
+        return rayAttacks(sq, occupied, BISHOP_DIRS);
+    }
+
+    // -------------------------------------------------------------
+    // マジックビットボード
+    // -------------------------------------------------------------
+
+    Magic rookMagics[64];
+    Magic bishopMagics[64];
+
+    static Bitboard rookTable[0x19000];  // 全マス合計 102400 通り
+    static Bitboard bishopTable[0x1480]; // 全マス合計 5248 通り
+
+    // マジック定数 (マス番号は sq = row * 8 + col)
+    // 乱数探索で見つけたものを埋め込んであり、起動時は表を埋めるだけで済む
+    static const Bitboard ROOK_MAGICS[64] = {
+        0x0480046281400010ULL, 0x1040100040002002ULL, 0x8780200008300180ULL, 0x8880060800100080ULL,
+        0x8200020104100820ULL, 0x0200100104020008ULL, 0x0480010000800200ULL, 0x4E00008201005024ULL,
+        0x1000800080400020ULL, 0x0080401000402001ULL, 0x0104802002801000ULL, 0x4401808010003800ULL,
+        0x8001801801140080ULL, 0x0002000810020004ULL, 0x0002004402004108ULL, 0x0011800300004180ULL,
+        0x4540008020408006ULL, 0x0000404000201001ULL, 0x7D10010100200040ULL, 0x1380808008001002ULL,
+        0x4408010005000810ULL, 0x0012008080020400ULL, 0x0002040002081001ULL, 0x102202000444810CULL,
+        0x0100400080208001ULL, 0x4800400140201002ULL, 0x1060100080200082ULL, 0x00E0100080080084ULL,
+        0x0001000500080010ULL, 0x4002000600100419ULL, 0x0000020400104108ULL, 0x4805800080004100ULL,
+        0x0280002001400240ULL, 0xA010002000400040ULL, 0x0430124103002000ULL, 0x02820A0042002010ULL,
+        0x0131001005000800ULL, 0x0C01000401000208ULL, 0x8102010204001008ULL, 0x0802004092001104ULL,
+        0x4C40004020808002ULL, 0x4410500420024000ULL, 0x00C0100020008080ULL, 0x0000100008008080ULL,
+        0x0004008008008004ULL, 0x0802000804010100ULL, 0x0001011002040008ULL, 0x00330044008A0009ULL,
+        0x1000400280022480ULL, 0x0840004880200880ULL, 0x0000200080100080ULL, 0x8044080480100080ULL,
+        0x0100040080080080ULL, 0x2084010002004040ULL, 0x0040020850410400ULL, 0x000900A114084200ULL,
+        0x00008002204A1101ULL, 0x0801004000201081ULL, 0x4300C0200011000DULL, 0x1385002008041001ULL,
+        0x140A0084A0181032ULL, 0x040300040018020DULL, 0x0000280201009004ULL, 0x0003000208902041ULL};
+
+    static const Bitboard BISHOP_MAGICS[64] = {
+        0x48081010008A2A80ULL, 0x0102C40404821100ULL, 0x0021480880800180ULL, 0x0004504201800180ULL,
+        0x0004042111103108ULL, 0xC242086208200204ULL, 0x1000640220900350ULL, 0x10008020901008C4ULL,
+        0x0000312208080880ULL, 0x0220021002009900ULL, 0x0802120C24082080ULL, 0x0044110404810900ULL,
+        0x40002848400A0000ULL, 0x2020409004201400ULL, 0x1000020804028830ULL, 0x0008002414040491ULL,
+        0x0008403429080820ULL, 0x0108001090209080ULL, 0x6424084043060030ULL, 0x88A8103404208810ULL,
+        0x0014004210140404ULL, 0x800A000101010148ULL, 0x0001004411180200ULL, 0x1000408101080121ULL,
+        0x0008068340104200ULL, 0x0112110008110800ULL, 0x042808200C004110ULL, 0x4048080004820002ULL,
+        0x2001010000104000ULL, 0x000C024008081A00ULL, 0x0404040025108214ULL, 0x2000404001010802ULL,
+        0x0041041381202000ULL, 0x01008C1005601680ULL, 0x01D010900002040AULL, 0x4040020080080080ULL,
+        0x00050A0400820102ULL, 0x8018820080041000ULL, 0xC2014101200A0802ULL, 0x0108061042308052ULL,
+        0x8004020242201020ULL, 0x08A1008884122030ULL, 0x0202010028020480ULL, 0x5080008401001020ULL,
+        0x8820204410400400ULL, 0x0020020041100200ULL, 0x0844504200400201ULL, 0x1882480200800020ULL,
+        0xC002080404040400ULL, 0x0382004108292000ULL, 0xA005020442088020ULL, 0x2000042820880310ULL,
+        0x0803008821011400ULL, 0x4086080218420420ULL, 0x00B0200282860400ULL, 0x1088880100420028ULL,
+        0x1030820110010500ULL, 0x0080012608025800ULL, 0x0002810084008800ULL, 0x8009001800420200ULL,
+        0x000B000010021202ULL, 0x433080C0104C0120ULL, 0x0002906048112040ULL, 0x40106000A1160020ULL};
+
+    static void initMagics(Magic magics[64], const Bitboard magicNumbers[64], Bitboard *table,
+                           Bitboard (*slow)(int, Bitboard))
+    {
+        int size = 0;
+        for (int sq = 0; sq < 64; sq++)
+        {
+            Magic &m = magics[sq];
+
+            // 盤端のマスは駒があっても利きが変わらないのでマスクから除く
+            Bitboard edges = ((rowBB(0) | rowBB(7)) & ~rowBB(rowOf(sq))) |
+                             ((fileBB(0) | fileBB(7)) & ~fileBB(colOf(sq)));
+            m.mask = slow(sq, 0) & ~edges;
+            m.magic = magicNumbers[sq];
+            m.shift = 64 - popcount(m.mask);
+            m.attacks = (sq == 0) ? table : magics[sq - 1].attacks + size;
+
+            // mask の全部分集合を列挙し (Carry-Rippler)、正解の利きを表に書き込む
+            Bitboard b = 0;
+            size = 0;
+            do
+            {
+                m.attacks[m.index(b)] = slow(sq, b);
+                size++;
+                b = (b - m.mask) & m.mask;
+            } while (b);
+        }
+    }
+
+    static bool buildTables()
+    {
+        const int knight_moves[8][2] = {{2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}};
+
+        for (int sq = 0; sq < 64; sq++)
+        {
+            knight[sq] = 0;
+            for (int i = 0; i < 8; i++)
+                knight[sq] |= stepBB(sq, knight_moves[i][0], knight_moves[i][1]);
+
+            king[sq] = 0;
+            for (int dr = -1; dr <= 1; dr++)
+                for (int dc = -1; dc <= 1; dc++)
+                    if (dr != 0 || dc != 0)
+                        king[sq] |= stepBB(sq, dr, dc);
+
+            // 白は上 (row - 1)、黒は下 (row + 1) へ斜めに利く
+            pawn[WHITE][sq] = stepBB(sq, -1, -1) | stepBB(sq, -1, 1);
+            pawn[BLACK][sq] = stepBB(sq, 1, -1) | stepBB(sq, 1, 1);
+        }
+
+        initMagics(rookMagics, ROOK_MAGICS, rookTable, rookSlow);
+        initMagics(bishopMagics, BISHOP_MAGICS, bishopTable, bishopSlow);
+
+        // 2マス間・2マスを通る直線 (ピンやチェックの遮断判定に使う)
+        for (int a = 0; a < 64; a++)
+        {
+            for (int b = 0; b < 64; b++)
+            {
+                betweenBB[a][b] = lineBB[a][b] = 0;
+                if (a == b)
+                    continue;
+                Bitboard (*const sliders[2])(int, Bitboard) = {rookSlow, bishopSlow};
+                for (auto slow : sliders)
+                {
+                    if (slow(a, 0) & squareBB(b))
+                    {
+                        lineBB[a][b] = (slow(a, 0) & slow(b, 0)) | squareBB(a) | squareBB(b);
+                        betweenBB[a][b] = slow(a, squareBB(b)) & slow(b, squareBB(a));
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    void init()
+    {
+        // 関数内staticの初期化はスレッドセーフに一度だけ実行される
+        static const bool initialized = buildTables();
+        (void)initialized;
+    }
+}
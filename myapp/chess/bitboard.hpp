@@ -0,0 +1,131 @@
+#pragma once
+
+//+++
+// ビットボード (64bit集合) による盤面表現の基礎部分
+// ・マス番号は sq = row * 8 + col (row 0 = 8段目, col 0 = aファイル)
+//   → 既存の board[r][c] / Move の座標系と同じ並び
+// ・駒コードは color * 6 + type (NO_PIECE = 12)
+//+++
+
+#include <cstdint>
+
+using Bitboard = std::uint64_t;
+
+enum Color
+{
+    WHITE = 0,
+    BLACK = 1
+};
+
+enum PieceType
+{
+    PAWN = 0,
+    KNIGHT,
+    BISHOP,
+    ROOK,
+    QUEEN,
+    KING
+};
+
+constexpr int NO_PIECE = 12;
+constexpr int NO_SQUARE = -1;
+
+// -------------------------------------------------------------
+// マス/駒コードのヘルパー
+// -------------------------------------------------------------
+
+constexpr int makeSquare(int row, int col) { return row * 8 + col; }
+constexpr int rowOf(int sq) { return sq >> 3; }
+constexpr int colOf(int sq) { return sq & 7; }
+
+constexpr int makePiece(int color, int type) { return color * 6 + type; }
+constexpr int colorOf(int piece) { return piece / 6; }
+constexpr int typeOf(int piece) { return piece % 6; }
+
+constexpr Bitboard squareBB(int sq) { return Bitboard(1) << sq; }
+
+constexpr Bitboard FILE_A_BB = 0x0101010101010101ULL;
+constexpr Bitboard ROW_0_BB = 0xFFULL; // 8段目
+
+constexpr Bitboard fileBB(int col) { return FILE_A_BB << col; }
+constexpr Bitboard rowBB(int row) { return ROW_0_BB << (8 * row); }
+
+inline int popcount(Bitboard b) { return __builtin_popcountll(b); }
+inline int lsb(Bitboard b) { return __builtin_ctzll(b); }
+
+// 最下位ビットのマス番号を返し、そのビットを取り除く
+inline int popLsb(Bitboard &b)
+{
+    int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+// 駒コード <-> 文字 ('P', 'n', ... / 空マスは '*')
+char pieceToChar(int piece);
+int charToPiece(char c);
+
+// -------------------------------------------------------------
+// 利き (攻撃範囲) テーブル
+// -------------------------------------------------------------
+
+// PEXT (BMI2) が使えるCPU向けにビルドされた場合はマジック乗算の代わりに使う
+#if defined(__BMI2__) && !defined(CHESS_NO_PEXT)
+#include <immintrin.h>
+#define CHESS_USE_PEXT 1
+#endif
+
+// 走り駒の利き表 (マジックビットボード)
+// occupied & mask を添字に変換し、事前計算した利きを1回の表引きで得る
+struct Magic
+{
+    Bitboard mask;     // 利きを遮りうるマス (盤端を除く)
+    Bitboard magic;    // マジック定数 (PEXT使用時は未使用)
+    Bitboard *attacks; // このマス用の表の先頭
+    unsigned shift;
+
+    unsigned index(Bitboard occupied) const
+    {
+#ifdef CHESS_USE_PEXT
+        return unsigned(_pext_u64(occupied, mask));
+#else
+        return unsigned(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+namespace Attacks
+{
+    // 起動時に一度だけ呼ぶ (ChessGameのコンストラクタから呼ばれる)
+    void init();
+
+    extern Bitboard knight[64];
+    extern Bitboard king[64];
+    extern Bitboard pawn[2][64]; // pawn[color][sq]: colorのポーンがsqから利くマス
+
+    extern Bitboard betweenBB[64][64]; // a-b間のマス (両端を含まない、一直線上に無ければ0)
+    extern Bitboard lineBB[64][64];    // a, b を通る直線全体 (一直線上に無ければ0)
+
+    extern Magic rookMagics[64];
+    extern Magic bishopMagics[64];
+
+    // 走り駒の利き (occupied で遮られる)
+    inline Bitboard rook(int sq, Bitboard occupied)
+    {
+        const Magic &m = rookMagics[sq];
+        return m.attacks[m.index(occupied)];
+    }
+    inline Bitboard bishop(int sq, Bitboard occupied)
+    {
+        const Magic &m = bishopMagics[sq];
+        return m.attacks[m.index(occupied)];
+    }
+    inline Bitboard queen(int sq, Bitboard occupied) { return rook(sq, occupied) | bishop(sq, occupied); }
+
+    inline Bitboard between(int a, int b) { return betweenBB[a][b]; }
+    inline Bitboard line(int a, int b) { return lineBB[a][b]; }
+
+    // 1マスずつ伸ばす計算版 (表の構築と検証・ベンチマーク用)
+    Bitboard rookSlow(int sq, Bitboard occupied);
+    Bitboard bishopSlow(int sq, Bitboard occupied);
+}
@@ -1,93 +1,63 @@
 #include "chess_game.hpp"
 
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
 /**
  * version 2.2
  *
  * ポーンに付いてバグあり（プロモーション周り）
  * アンパッサン実装なし
  * 50手ルール実装なし
- * FEN記法との相性は△、完全な互換は未実装
+ * FEN は全フィールドを読み書きできる (アンパサンのマスは保持するだけで、手としては生成しない)
  * AIはコマ価値/位置価値/チェックボーナスから評価
  */
 
-// -------------------------------------------------------------
-// 位置価値テーブル (Piece-Square Tables: PSTs) の定義
-// -------------------------------------------------------------
-
-// ポーン：中央支配と積極的な前進を評価
-const int PawnTable[8][8] = {
-    {0, 0, 0, 0, 0, 0, 0, 0},                        // 8段目 (プロモーション)
-    {80, 80, 80, 80, 80, 80, 80, 80},                // 7段目 (プロモーション間近: +80)
-    {50, 50, 60, 50, 50, 60, 50, 40},                // 6段目 (ポーン前進を強く奨励)
-    {40, 40, 30, 60, 60, 30, 20, 20},                // 5段目
-    {30, 30, 40, 60, 60, 40, 30, 30},                // 4段目
-    {0, 0, 30, 10, 10, 30, 0, 0},                    // 3段目 (中央ポーンに僅かなボーナス)
-    {-20, -20, -20, -30, -30, -20, -20, -20},        // 2段目 (初期位置のポーンにペナルティ)
-    {-100, -100, -100, -100, -100, -100, -100, -100} // 1段目 (あり得ない)
-};
+// 5x5 のキング周辺 (キングから2マス以内)
+static Bitboard KingZone[64];
 
-const int KnightTable[8][8] = {
-    {-50, -40, -30, -30, -30, -30, -40, -50},
-    {-40, -20, 0, 5, 5, 0, -20, -40},
-    {-30, 5, 5, 5, 5, 5, 5, -30},
-    {-30, 0, 10, 10, 10, 10, 0, -30},
-    {-30, 5, 10, 10, 10, 10, 5, -30},
-    {-30, 0, 5, 5, 5, 5, 0, -30},
-    {-40, -20, 0, 0, 0, 0, -20, -40},
-    {-30, -10, -10, -10, -10, -10, -10, -30}};
-
-// ビショップ: 中央向きを評価
-const int BishopTable[8][8] = {
-    {-20, -10, -10, -10, -10, -10, -10, -20},
-    {-10, 0, 0, 0, 0, 0, 0, -10},
-    {-10, 0, 5, 10, 10, 5, 0, -10},
-    {-10, 5, 10, 15, 15, 10, 5, -10}, // 中央(d4, e4)の斜線上に +15 のボーナス
-    {-10, 0, 10, 15, 15, 10, 0, -10},
-    {-10, 5, 5, 10, 10, 5, 5, -10},
-    {-10, 0, 0, 0, 0, 0, 0, -10},
-    {-20, -10, -10, -10, -10, -10, -10, -20}};
-
-// ルーク: 7段目/オープンファイルを評価
-const int RookTable[8][8] = {
-    {0, 0, 0, 5, 5, 0, 0, 0},
-    {-5, 0, 0, 0, 0, 0, 0, -5},
-    {-5, 0, 0, 0, 0, 0, 0, -5},
-    {-5, 0, 0, 0, 0, 0, 0, -5},
-    {-5, 0, 0, 0, 0, 0, 0, -5},
-    {-5, 0, 0, 0, 0, 0, 0, -5},
-    {5, 10, 10, 10, 10, 10, 10, 5}, // 7段目ルークは高得点
-    {0, 0, 0, 0, 0, 0, 0, 0}};
-
-// クイーン: 中央を評価
-const int QueenTable[8][8] = {
-    {-20, -10, -10, -5, -5, -10, -10, -20},
-    {-10, 0, 0, 0, 0, 0, 0, -10},
-    {-10, 0, 5, 5, 5, 5, 0, -10},
-    {-5, 0, 5, 5, 5, 5, 0, -5},
-    {0, 0, 5, 5, 5, 5, 0, -5},
-    {-10, 5, 5, 5, 5, 5, 0, -10},
-    {-10, 0, 5, 0, 0, 0, 0, -10},
-    {-20, -10, -10, -5, -5, -10, -10, -20}};
-
-// キング (ミドルゲーム):
-const int KingTable[8][8] = {
-    // 序中盤の評価: 隅に高いボーナス
-    {-30, -40, -40, -50, -50, -40, -40, -30},
-    {-30, -40, -40, -50, -50, -40, -40, -30},
-    {-30, -40, -40, -50, -50, -40, -40, -30},
-    {-30, -40, -40, -50, -50, -40, -40, -30},
-    {-20, -30, -30, -40, -40, -30, -30, -20},
-    {-10, -20, -20, -20, -20, -20, -20, -10},
-    {20, 20, 0, 0, 0, 0, 20, 20}, // 2段目のキングは少し安全
-    {20, 30, 10, 0, 0, 10, 30, 20}};
+static void initKingZones()
+{
+    static const bool initialized = []()
+    {
+        for (int sq = 0; sq < 64; sq++)
+        {
+            KingZone[sq] = 0;
+            for (int dr = -2; dr <= 2; dr++)
+            {
+                for (int dc = -2; dc <= 2; dc++)
+                {
+                    int nr = rowOf(sq) + dr, nc = colOf(sq) + dc;
+                    if (nr >= 0 && nr < 8 && nc >= 0 && nc < 8)
+                        KingZone[sq] |= squareBB(makeSquare(nr, nc));
+                }
+            }
+        }
+        return true;
+    }();
+    (void)initialized;
+}
 
 // -------------------------------------------------------------
 // ChessGameクラス
 // -------------------------------------------------------------
 
 // コンストラクタ
-ChessGame::ChessGame()
+ChessGame::ChessGame(std::size_t hashSizeMB)
+    : tt_(std::make_shared<TranspositionTable>(hashSizeMB)),
+      pawnTable_(std::make_shared<PawnHashTable>(PAWN_HASH_SIZE_KB)),
+      stop_(std::make_shared<std::atomic<bool>>(false)),
+      ponder_(std::make_shared<std::atomic<bool>>(false)),
+      sharedNodes_(std::make_shared<std::atomic<std::uint64_t>>(0)),
+      bookTimeBank_(std::make_shared<std::atomic<int>>(0))
 {
+    searchLimits_.timeMs = 1000; // 既定は1手1秒
+
+    Attacks::init();
+    Zobrist::init();
+    initKingZones();
     initBoard();
     std::srand(std::time(0));
 }
@@ -107,24 +77,96 @@ bool ChessGame::algebraicToCoords(const std::string &alg, int &row, int &col) co
 
 void ChessGame::printBoard() const
 {
-    std::cout << "     a   b   c   d   e   f   g   h\n";
-    std::cout << "   ┌───┬───┬───┬───┬───┬───┬───┬───┐\n";
+    std::cout << "     a   b   c   d   e   f   g   h\n";
+    std::cout << "   ┌───┬───┬───┬───┬───┬───┬───┬───┐\n";
     for (int i = 0; i < 8; i++)
     {
         std::cout << " " << 8 - i << " │";
         for (int j = 0; j < 8; j++)
         {
-            char c = board[i][j].type;
+            char c = pieceToChar(mailbox_[makeSquare(i, j)]);
             std::string piece_str = (c == '*') ? " " : std::string(1, c);
             std::cout << " " << piece_str << " │";
         }
         std::cout << " " << 8 - i << "\n";
         if (i != 7)
-            std::cout << "   ├───┼───┼───┼───┼───┼───┼───┼───┤\n";
+            std::cout << "   ├───┼───┼───┼───┼───┼───┼───┼───┤\n";
         else
-            std::cout << "   └───┴───┴───┴───┴───┴───┴───┴───┘\n";
+            std::cout << "   └───┴───┴───┴───┴───┴───┴───┴───┘\n";
     }
-    std::cout << "     a   b   c   d   e   f   g   h\n";
+    std::cout << "     a   b   c   d   e   f   g   h\n";
+}
+
+// -------------------------------------------------------------
+// ビットボード操作
+// -------------------------------------------------------------
+
+void ChessGame::clearBoard()
+{
+    for (int color = WHITE; color <= BLACK; color++)
+    {
+        for (int type = PAWN; type <= KING; type++)
+            pieceBB_[color][type] = 0;
+        colorBB_[color] = 0;
+    }
+    occupiedBB_ = 0;
+    for (int sq = 0; sq < 64; sq++)
+        mailbox_[sq] = NO_PIECE;
+    psqScore_ = 0;
+    phase_ = 0;
+    pawnKey_ = 0;
+
+    sideToMove_ = WHITE;
+    key_ = Zobrist::castling[castlingIndex()];
+    rule50_ = 0;
+    gamePly_ = 0;
+    epSquare_ = NO_SQUARE;
+    keyHistory_.clear();
+}
+
+void ChessGame::putPiece(int piece, int sq)
+{
+    Bitboard b = squareBB(sq);
+    pieceBB_[colorOf(piece)][typeOf(piece)] |= b;
+    colorBB_[colorOf(piece)] |= b;
+    occupiedBB_ |= b;
+    mailbox_[sq] = piece;
+    key_ ^= Zobrist::psq[piece][sq];
+    if (typeOf(piece) == PAWN)
+        pawnKey_ ^= Zobrist::psq[piece][sq];
+    psqScore_ += PSQT[piece][sq];
+    phase_ += PhaseWeight[typeOf(piece)];
+}
+
+void ChessGame::removePiece(int sq)
+{
+    int piece = mailbox_[sq];
+    Bitboard b = squareBB(sq);
+    pieceBB_[colorOf(piece)][typeOf(piece)] ^= b;
+    colorBB_[colorOf(piece)] ^= b;
+    occupiedBB_ ^= b;
+    mailbox_[sq] = NO_PIECE;
+    key_ ^= Zobrist::psq[piece][sq];
+    if (typeOf(piece) == PAWN)
+        pawnKey_ ^= Zobrist::psq[piece][sq];
+    psqScore_ -= PSQT[piece][sq];
+    phase_ -= PhaseWeight[typeOf(piece)];
+}
+
+// to は空マスであること (取る駒は先に removePiece しておく)
+void ChessGame::movePiece(int from, int to)
+{
+    int piece = mailbox_[from];
+    Bitboard b = squareBB(from) | squareBB(to);
+    pieceBB_[colorOf(piece)][typeOf(piece)] ^= b;
+    colorBB_[colorOf(piece)] ^= b;
+    occupiedBB_ ^= b;
+    mailbox_[to] = piece;
+    mailbox_[from] = NO_PIECE;
+    key_ ^= Zobrist::psq[piece][from] ^ Zobrist::psq[piece][to];
+    if (typeOf(piece) == PAWN)
+        pawnKey_ ^= Zobrist::psq[piece][from] ^ Zobrist::psq[piece][to];
+    psqScore_ += PSQT[piece][to] - PSQT[piece][from];
 }
 
 void ChessGame::updateCastlingRights(int r1, int c1)
@@ -149,160 +191,194 @@ void ChessGame::updateCastlingRights(int r1, int c1)
     }
 }
 
-// メインループ用 (CastlingRightsを更新)
-void ChessGame::makeMove(Move m)
+// キャスリング権を4bitにまとめる (Zobristキーの添字)
+int ChessGame::castlingIndex() const
 {
-    // makeMoveInternalのロジックを使用し、CastlingRightsの更新を追加
-    int r1 = m.first.first, c1 = m.first.second;
-    int r2 = m.second.first, c2 = m.second.second;
+    int index = 0;
+    if (!castlingRights.whiteKingMoved && !castlingRights.whiteRookKSidesMoved)
+        index |= 1;
+    if (!castlingRights.whiteKingMoved && !castlingRights.whiteRookQSidesMoved)
+        index |= 2;
+    if (!castlingRights.blackKingMoved && !castlingRights.blackRookKSidesMoved)
+        index |= 4;
+    if (!castlingRights.blackKingMoved && !castlingRights.blackRookQSidesMoved)
+        index |= 8;
+    return index;
+}
 
-    // キャスリングの特殊処理
-    if (std::toupper(board[r1][c1].type) == 'K' && std::abs(c1 - c2) == 2)
+// キングとルークが元のマスにあるキャスリング権だけを残す
+// (initBoardWithStrings は駒の位置に関係なく全てのキャスリング権を与えるため)
+int ChessGame::castlingIndexOnBoard() const
+{
+    int castling = castlingIndex();
+    if (mailbox_[makeSquare(7, 4)] != makePiece(WHITE, KING))
+        castling &= ~3;
+    if (mailbox_[makeSquare(7, 7)] != makePiece(WHITE, ROOK))
+        castling &= ~1;
+    if (mailbox_[makeSquare(7, 0)] != makePiece(WHITE, ROOK))
+        castling &= ~2;
+    if (mailbox_[makeSquare(0, 4)] != makePiece(BLACK, KING))
+        castling &= ~12;
+    if (mailbox_[makeSquare(0, 7)] != makePiece(BLACK, ROOK))
+        castling &= ~4;
+    if (mailbox_[makeSquare(0, 0)] != makePiece(BLACK, ROOK))
+        castling &= ~8;
+    return castling;
+}
+
+// 手番を設定する (盤面だけが与えられた場合に、探索前に手番を合わせる)
+void ChessGame::setSideToMove(bool white)
+{
+    int side = white ? WHITE : BLACK;
+    if (side != sideToMove_)
     {
-        // ... (キャスリングの移動ロジック - makeMoveInternalとほぼ同じ)
-        if (c2 > c1)
-        { // キングサイド
-            board[r2][c2] = board[r1][c1];
-            board[r1][c1] = Piece('*', true);
-            board[r2][c2 - 1] = board[r1][7];
-            board[r1][7] = Piece('*', true);
-        }
-        else
-        { // クイーンサイド
-            board[r2][c2] = board[r1][c1];
-            board[r1][c1] = Piece('*', true);
-            board[r2][c2 + 1] = board[r1][0];
-            board[r1][0] = Piece('*', true);
-        }
+        sideToMove_ = side;
+        key_ ^= Zobrist::side;
     }
-    else
-    { // 通常の移動
-        board[r2][c2] = board[r1][c1];
-        board[r1][c1] = Piece('*', true);
+}
 
-        // 移動後、ポーンの昇格をチェックする
-        if (std::toupper(board[r2][c2].type) == 'P')
-        {
-            bool isWhite = board[r2][c2].isWhite;
-            // 白: 0行目 (1段目)、黒: 7行目 (8段目)
-            if ((isWhite && r2 == 0) || (!isWhite && r2 == 7))
-            {
-                // クイーンに昇格
-                board[r2][c2].type = isWhite ? 'Q' : 'q';
-            }
-        }
-    }
-    updateCastlingRights(r1, c1);
+// メインループ用 (履歴を記録)
+void ChessGame::makeMove(Move m)
+{
+    int from = makeSquare(m.first.first, m.first.second);
+    int to = makeSquare(m.second.first, m.second.second);
+
+    // 空マスからの移動 (合法手が無い時の {{0,0},{0,0}} など) は無視する
+    if (from == to || mailbox_[from] == NO_PIECE)
+        return;
+
+    // 動かす駒の色を手番とする
+    setSideToMove(colorOf(mailbox_[from]) == WHITE);
+
+    // makeMoveInternalのロジックをそのまま使用
+    // (CastlingRights、Zobristキー、キー履歴もそこで更新される)
+    bool doublePush = typeOf(mailbox_[from]) == PAWN && std::abs(rowOf(to) - rowOf(from)) == 2;
+    UndoInfo undo;
+    makeMoveInternal(toPackedMove(m), undo);
+    gamePly_++;
 
-    position_history_.push_back(getBoardStateFEN(board[r2][c2].isWhite));
+    // アンパサンのマスは FEN に書くためだけに持つ (探索では使わないので makeMoveInternal では扱わない)
+    epSquare_ = doublePush ? (from + to) / 2 : NO_SQUARE;
+}
+
+// 座標のペアを探索用の指し手に変換する (合法かどうかは確かめない)
+// キングが2列動く手はキャスリング、ポーンが最終段に進む手はクイーンへの昇格とみなす
+PackedMove ChessGame::toPackedMove(const Move &m) const
+{
+    int from = makeSquare(m.first.first, m.first.second);
+    int to = makeSquare(m.second.first, m.second.second);
+    int type = (mailbox_[from] != NO_PIECE) ? typeOf(mailbox_[from]) : NO_PIECE;
+
+    if (type == KING && std::abs(m.first.second - m.second.second) == 2)
+        return PackedMove(from, to, MOVE_CASTLING);
+    if (type == PAWN && (rowOf(to) == 0 || rowOf(to) == 7))
+        return PackedMove(from, to, MOVE_PROMOTION, QUEEN);
+    return PackedMove(from, to);
 }
 
 // AI探索用
-void ChessGame::makeMoveInternal(Move m, Piece &capturedPiece)
+void ChessGame::makeMoveInternal(PackedMove m, UndoInfo &undo)
 {
-    int r1 = m.first.first, c1 = m.first.second;
-    int r2 = m.second.first, c2 = m.second.second;
+    int from = m.from();
+    int to = m.to();
+    int r1 = rowOf(from), c1 = colOf(from);
+    int r2 = rowOf(to), c2 = colOf(to);
+    int piece = mailbox_[from];
+
+    undo.captured = mailbox_[to];
+    undo.castlingRights = castlingRights;
+    undo.rule50 = rule50_;
 
-    capturedPiece = board[r2][c2];
+    // 反復検出用に指す前のキーを記録
+    keyHistory_.push_back(key_);
+    key_ ^= Zobrist::castling[castlingIndex()];
 
     // キャスリングの特殊処理
-    if (std::toupper(board[r1][c1].type) == 'K' && std::abs(c1 - c2) == 2)
+    if (m.kind() == MOVE_CASTLING)
     {
         if (c2 > c1)
         { // キングサイド
-            board[r2][c2] = board[r1][c1];
-            board[r1][c1] = Piece('*', true);
-            board[r2][c2 - 1] = board[r1][7];
-            board[r1][7] = Piece('*', true);
+            movePiece(makeSquare(r1, 7), makeSquare(r2, c2 - 1));
         }
         else
         { // クイーンサイド
-            board[r2][c2] = board[r1][c1];
-            board[r1][c1] = Piece('*', true);
-            board[r2][c2 + 1] = board[r1][0];
-            board[r1][0] = Piece('*', true);
+            movePiece(makeSquare(r1, 0), makeSquare(r2, c2 + 1));
         }
-        capturedPiece.type = 'C';
+        movePiece(from, to);
     }
     // キャスリング以外の場合
     else
     {
-        board[r2][c2] = board[r1][c1];
-        board[r1][c1] = Piece('*', true);
+        if (undo.captured != NO_PIECE)
+            removePiece(to);
+        movePiece(from, to);
 
-        // ★ 3. プロモーションをチェック (capturedPieceは変更しない) ★
-        if (std::toupper(board[r2][c2].type) == 'P')
+        // 昇格 (白: 0行目、黒: 7行目)
+        if (m.kind() == MOVE_PROMOTION)
         {
-            bool isWhite = board[r2][c2].isWhite;
-            // 白: 0行目 (1段目)、黒: 7行目 (8段目)
-            if ((isWhite && r2 == 0) || (!isWhite && r2 == 7))
-            {
-                // クイーンに昇格
-                board[r2][c2].type = isWhite ? 'Q' : 'q';
-
-                // ★ 4. プロモーションがあったことを示すためにcapturedPieceを更新 ★
-                //   - キャプチャが無かった場合 (capturedPiece.type == '*') のみ、
-                //     特別なフラグ 'X' をセットし、Undo時に空マスを戻すことを通知
-                //   - キャプチャがあった場合、capturedPieceはキャプチャされた敵駒のままにする
-                if (capturedPiece.type == '*')
-                {
-                    capturedPiece.type = 'X';
-                }
-            }
+            removePiece(to);
+            putPiece(makePiece(colorOf(piece), m.promotion()), to);
         }
     }
+
+    // 移動元・移動先 (ルークが取られた場合) のキャスリング権を更新
+    updateCastlingRights(r1, c1);
+    updateCastlingRights(r2, c2);
+    key_ ^= Zobrist::castling[castlingIndex()];
+
+    // 駒取り・ポーンの移動は元に戻せない手 (それ以前の局面は反復し得ない)
+    if (undo.captured != NO_PIECE || typeOf(piece) == PAWN)
+        rule50_ = 0;
+    else
+        rule50_++;
+
+    sideToMove_ ^= 1;
+    key_ ^= Zobrist::side;
 }
 
 // AI探索用 Undo
-void ChessGame::unmakeMoveInternal(Move m, Piece capturedPiece)
+void ChessGame::unmakeMoveInternal(PackedMove m, const UndoInfo &undo)
 {
-    int r1 = m.first.first, c1 = m.first.second;
-    int r2 = m.second.first, c2 = m.second.second;
+    int from = m.from();
+    int to = m.to();
+    int r1 = rowOf(from), c1 = colOf(from);
+    int r2 = rowOf(to), c2 = colOf(to);
+
+    sideToMove_ ^= 1;
+    key_ ^= Zobrist::side ^ Zobrist::castling[castlingIndex()];
 
-    if (capturedPiece.type == 'C')
+    if (m.kind() == MOVE_CASTLING)
     { // キャスリングのUndo
+        movePiece(to, from);
         if (c2 > c1)
         { // キングサイド
-            board[r1][c1] = board[r2][c2];
-            board[r2][c2] = Piece('*', true);
-            board[r1][7] = board[r2][c2 - 1];
-            board[r2][c2 - 1] = Piece('*', true);
+            movePiece(makeSquare(r2, c2 - 1), makeSquare(r1, 7));
         }
         else
         { // クイーンサイド
-            board[r1][c1] = board[r2][c2];
-            board[r2][c2] = Piece('*', true);
-            board[r1][0] = board[r2][c2 + 1];
-            board[r2][c2 + 1] = Piece('*', true);
+            movePiece(makeSquare(r2, c2 + 1), makeSquare(r1, 0));
         }
-    } // ★★★ 修正: キャプチャを伴わないプロモーションのUndo (フラグ 'X' を使用) ★★★
-    // r2の駒（Q/q）をポーンP/pに戻し、r2は空マスに戻す
-    else if (capturedPiece.type == 'X')
-    {
-        // 1. r2のプロモーションされた駒（Q/q）をr1に戻す
-        board[r1][c1] = board[r2][c2];
-
-        // 2. r1に戻された駒をポーンに戻す
-        board[r1][c1].type = board[r1][c1].isWhite ? 'P' : 'p';
-
-        // 3. r2は空マスに戻す
-        board[r2][c2] = Piece('*', true);
     }
-    // ★★★ 修正: 通常のUndo処理 (キャプチャありプロモーションも含む) ★★★
     else
     {
-        // r2の駒（プロモーション後のQ/q、または他の駒）をr1に戻す
-        board[r1][c1] = board[r2][c2];
-
-        // r2の駒がプロモーション後のクイーンであればポーンに戻す
-        if (std::toupper(board[r1][c1].type) == 'Q' && (r1 == 0 || r1 == 7))
+        // 昇格した駒はポーンに戻す
+        if (m.kind() == MOVE_PROMOTION)
         {
-            board[r1][c1].type = board[r1][c1].isWhite ? 'P' : 'p';
+            int color = colorOf(mailbox_[to]);
+            removePiece(to);
+            putPiece(makePiece(color, PAWN), to);
         }
+        movePiece(to, from);
 
-        // r2にキャプチャされた駒（または'*'）を戻す
-        board[r2][c2] = capturedPiece;
+        // 取られた駒を戻す
+        if (undo.captured != NO_PIECE)
+            putPiece(undo.captured, to);
     }
+
+    castlingRights = undo.castlingRights;
+    key_ ^= Zobrist::castling[castlingIndex()];
+    rule50_ = undo.rule50;
+    keyHistory_.pop_back();
 }
 
 // -------------------------------------------------------------
@@ -311,707 +387,1701 @@ void ChessGame::unmakeMoveInternal(Move m, Piece capturedPiece)
 
 bool ChessGame::isKingOnBoard(bool white) const
 {
-    // findKing(white) を呼び出して、座標が {-1, -1} でないか確認する
-    std::pair<int, int> kingPos = findKing(white);
-    return kingPos.first != -1;
+    return pieceBB_[white ? WHITE : BLACK][KING] != 0;
 }
 
 std::pair<int, int> ChessGame::findKing(bool white) const
 {
-    for (int r = 0; r < 8; r++)
+    Bitboard kings = pieceBB_[white ? WHITE : BLACK][KING];
+    if (!kings)
+        return {-1, -1};
+    int sq = lsb(kings);
+    return {rowOf(sq), colOf(sq)};
+}
+
+// occupied を盤面の占有とみなしたとき、sqに利いている駒 (両方の色)
+Bitboard ChessGame::attackersTo(int sq, Bitboard occupied) const
+{
+    const Bitboard(*p)[6] = pieceBB_;
+    return (Attacks::pawn[BLACK][sq] & p[WHITE][PAWN]) |
+           (Attacks::pawn[WHITE][sq] & p[BLACK][PAWN]) |
+           (Attacks::knight[sq] & (p[WHITE][KNIGHT] | p[BLACK][KNIGHT])) |
+           (Attacks::king[sq] & (p[WHITE][KING] | p[BLACK][KING])) |
+           (Attacks::rook(sq, occupied) & (p[WHITE][ROOK] | p[BLACK][ROOK] | p[WHITE][QUEEN] | p[BLACK][QUEEN])) |
+           (Attacks::bishop(sq, occupied) & (p[WHITE][BISHOP] | p[BLACK][BISHOP] | p[WHITE][QUEEN] | p[BLACK][QUEEN]));
+}
+
+// colorのキング(ksq)と相手の走り駒の間に1枚だけ挟まっている自駒
+Bitboard ChessGame::pinnedPieces(int color, int ksq) const
+{
+    const Bitboard *e = pieceBB_[color ^ 1];
+    Bitboard snipers = (Attacks::rook(ksq, 0) & (e[ROOK] | e[QUEEN])) |
+                       (Attacks::bishop(ksq, 0) & (e[BISHOP] | e[QUEEN]));
+    Bitboard pinned = 0;
+    while (snipers)
     {
-        for (int c = 0; c < 8; c++)
-        {
-            Piece p = board[r][c];
-            if (std::toupper(p.type) == 'K' && p.isWhite == white)
-            {
-                return {r, c};
-            }
-        }
+        Bitboard blockers = Attacks::between(ksq, popLsb(snipers)) & occupiedBB_;
+        if (popcount(blockers) == 1)
+            pinned |= blockers & colorBB_[color];
     }
-    return {-1, -1};
+    return pinned;
 }
 
 bool ChessGame::isSquareAttacked(int r, int c, bool attackingWhite) const
 {
-    // 1. ナイトによる攻撃チェック
-    int knight_moves[8][2] = {{2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}};
-    for (int i = 0; i < 8; i++)
+    // キングが盤上に無い場合 (findKing が {-1, -1} を返した場合)
+    if (r < 0 || c < 0)
+        return false;
+
+    return attackersTo(makeSquare(r, c), occupiedBB_) & colorBB_[attackingWhite ? WHITE : BLACK];
+}
+
+// -------------------------------------------------------------
+// 履歴保存と三回反復チェック
+// -------------------------------------------------------------
+
+// 現在の局面と同じキーが何回前に出現したか数える
+// (手番が同じ局面のみ、最後の取り返せない手までさかのぼれば十分)
+int ChessGame::repetitionCount() const
+{
+    int count = 0;
+    int size = (int)keyHistory_.size();
+    int limit = std::min(rule50_, size);
+    for (int i = 4; i <= limit; i += 2)
     {
-        int nr = r + knight_moves[i][0];
-        int nc = c + knight_moves[i][1];
-        if (nr >= 0 && nr < 8 && nc >= 0 && nc < 8)
+        if (keyHistory_[size - i] == key_)
+            count++;
+    }
+    return count;
+}
+
+bool ChessGame::isDrawByThreefoldRepetition(bool turnWhite) const
+{
+    if ((turnWhite ? WHITE : BLACK) != sideToMove_)
+        return false;
+
+    // 現在の局面を含めて3回以上出現したら引き分け
+    return repetitionCount() + 1 >= 3;
+}
+
+// -------------------------------------------------------------
+// 合法手生成
+// -------------------------------------------------------------
+
+void ChessGame::addMoves(int from, Bitboard targets, MoveList &moves) const
+{
+    while (targets)
+        moves.push_back(PackedMove(from, popLsb(targets)));
+}
+
+// allowed: 移動してよいマス (自駒のマスは含まない)
+void ChessGame::generateSlidingMoves(int sq, int type, Bitboard allowed, MoveList &moves) const
+{
+    Bitboard targets = 0;
+    if (type == ROOK || type == QUEEN)
+        targets |= Attacks::rook(sq, occupiedBB_);
+    if (type == BISHOP || type == QUEEN)
+        targets |= Attacks::bishop(sq, occupiedBB_);
+
+    addMoves(sq, targets & allowed, moves);
+}
+
+// GUI・経路生成用 (座標のペアに変換して返す)
+std::vector<Move> ChessGame::generateMoves(bool white) const
+{
+    MoveList moves;
+    generateLegalMoves(white, GEN_ALL, moves);
+
+    std::vector<Move> result;
+    result.reserve(moves.size());
+    for (PackedMove m : moves)
+        result.push_back(m.toMove());
+    return result;
+}
+
+// type: GEN_ALL = 全ての合法手
+//       GEN_CAPTURES = 駒を取る手と昇格 (キャスリングは含めない)
+//       GEN_QUIETS = それ以外 (駒を取らない移動とキャスリング)
+// fromMask: 動かす駒のマスを限定する (置換表の手やキラー手の合法性確認用)
+void ChessGame::generateLegalMoves(bool white, GenType type, MoveList &moves, Bitboard fromMask) const
+{
+    int us = white ? WHITE : BLACK;
+    int them = us ^ 1;
+    Bitboard own = colorBB_[us];
+    Bitboard enemy = colorBB_[them];
+    Bitboard kingBB = pieceBB_[us][KING];
+
+    // 移動先の種類 (自駒のマス以外から、取る手/取らない手を選ぶ)
+    Bitboard targetType = (type == GEN_CAPTURES) ? enemy : (type == GEN_QUIETS) ? ~occupiedBB_ : ~own;
+
+    // 1. 局面ごとに一度だけ、王手をかけている駒とピンされた駒を求める
+    //    (指し手ごとに盤面をコピーして確かめる必要はない)
+    Bitboard checkMask = ~Bitboard(0); // キング以外の駒が動けるマス (王手の時は王手を防ぐマスのみ)
+    Bitboard pinned = 0;
+    int ksq = NO_SQUARE;
+
+    if (kingBB)
+    {
+        ksq = lsb(kingBB);
+        Bitboard checkers = attackersTo(ksq, occupiedBB_) & enemy;
+        pinned = pinnedPieces(us, ksq);
+
+        if (kingBB & fromMask)
+        {
+            // キングの移動: 移動先に相手の利きが無いこと (キング自身は遮蔽物から外して判定)
+            Bitboard occupiedNoKing = occupiedBB_ ^ kingBB;
+            Bitboard kingTargets = Attacks::king[ksq] & targetType;
+            while (kingTargets)
+            {
+                int to = popLsb(kingTargets);
+                if (!(attackersTo(to, occupiedNoKing) & enemy))
+                    moves.push_back(PackedMove(ksq, to));
+            }
+        }
+
+        // 両王手ならキングが動く以外に無い
+        if (popcount(checkers) > 1)
+            return;
+
+        if (checkers)
+        {
+            // 王手: 王手駒を取るか、間に合駒をする手だけが許される
+            checkMask = Attacks::between(ksq, lsb(checkers)) | checkers;
+        }
+        else if (type != GEN_CAPTURES && (kingBB & fromMask))
         {
-            Piece p = board[nr][nc];
-            if (p.type != '*' && p.isWhite == attackingWhite && std::toupper(p.type) == 'N')
-                return true;
+            generateCastlingMoves(us, ksq, moves);
         }
     }
 
-    // 2. キングによる攻撃チェック
-    for (int dr = -1; dr <= 1; dr++)
+    // 2. キング以外の駒 (ピンされた駒はキングとピンしている駒を結ぶ線上のみ)
+    Bitboard pieces = own & ~kingBB & fromMask;
+    while (pieces)
     {
-        for (int dc = -1; dc <= 1; dc++)
+        int sq = popLsb(pieces);
+        int r = rowOf(sq), c = colOf(sq);
+        int pieceType = typeOf(mailbox_[sq]);
+
+        Bitboard legalMask = checkMask;
+        if (pinned & squareBB(sq))
+            legalMask &= Attacks::line(ksq, sq);
+        Bitboard allowed = legalMask & targetType;
+
+        if (pieceType == PAWN)
         {
-            if (dr == 0 && dc == 0)
+            int ni = r + (white ? -1 : 1);
+            if (ni < 0 || ni > 7)
                 continue;
-            int nr = r + dr;
-            int nc = c + dc;
-            if (nr >= 0 && nr < 8 && nc >= 0 && nc < 8)
+
+            // 昇格する前進は「取る手」の側に含める (昇格はクイーンのみ)
+            bool isPromotion = (ni == 0 || ni == 7);
+            bool pushes = (type == GEN_ALL) || ((type == GEN_CAPTURES) == isPromotion);
+            Bitboard pushAllowed = legalMask & ~occupiedBB_;
+            int one = makeSquare(ni, c);
+            if (pushes && !(occupiedBB_ & squareBB(one)))
             {
-                Piece p = board[nr][nc];
-                if (p.type != '*' && p.isWhite == attackingWhite && std::toupper(p.type) == 'K')
-                    return true;
+                if (pushAllowed & squareBB(one))
+                    moves.push_back(isPromotion ? PackedMove(sq, one, MOVE_PROMOTION, QUEEN) : PackedMove(sq, one));
+
+                bool isInitialPos = (white && r == 6) || (!white && r == 1);
+                int two = makeSquare(ni + (white ? -1 : 1), c);
+                if (isInitialPos && (pushAllowed & squareBB(two)))
+                {
+                    moves.push_back(PackedMove(sq, two));
+                }
             }
+            if (type != GEN_QUIETS)
+            {
+                Bitboard captures = Attacks::pawn[us][sq] & enemy & allowed;
+                if (isPromotion)
+                {
+                    while (captures)
+                        moves.push_back(PackedMove(sq, popLsb(captures), MOVE_PROMOTION, QUEEN));
+                }
+                else
+                {
+                    addMoves(sq, captures, moves);
+                }
+            }
+        }
+        else if (pieceType == KNIGHT)
+        {
+            addMoves(sq, Attacks::knight[sq] & allowed, moves);
+        }
+        else
+        {
+            generateSlidingMoves(sq, pieceType, allowed, moves);
         }
     }
+}
+
+// 置換表の手やキラー手がこの局面の合法手か (その駒の手だけを生成して確かめる)
+bool ChessGame::isMoveLegal(bool white, PackedMove m) const
+{
+    if (m.isNone())
+        return false;
+
+    int from = m.from();
+    if (mailbox_[from] == NO_PIECE || colorOf(mailbox_[from]) != (white ? WHITE : BLACK))
+        return false;
+
+    MoveList moves;
+    generateLegalMoves(white, GEN_ALL, moves, squareBB(from));
+    return moves.contains(m);
+}
+
+// 駒を取らず、昇格もしない手か (GEN_QUIETS で生成される手)
+bool ChessGame::isQuietMove(PackedMove m) const
+{
+    return mailbox_[m.to()] == NO_PIECE && m.kind() != MOVE_PROMOTION;
+}
+
+// キャスリング (キングが王手されておらず、通過するマスにも利きが無い場合のみ)
+void ChessGame::generateCastlingMoves(int us, int ksq, MoveList &moves) const
+{
+    bool white = (us == WHITE);
+    int rank = white ? 7 : 0;
+    bool king_moved = white ? castlingRights.whiteKingMoved : castlingRights.blackKingMoved;
+    if (ksq != makeSquare(rank, 4) || king_moved)
+        return;
+
+    int rook = makePiece(us, ROOK);
+    Bitboard enemy = colorBB_[us ^ 1];
+
+    // キングサイド
+    bool rook_ks_moved = white ? castlingRights.whiteRookKSidesMoved : castlingRights.blackRookKSidesMoved;
+    Bitboard ks_between = squareBB(makeSquare(rank, 5)) | squareBB(makeSquare(rank, 6));
+    if (!rook_ks_moved && mailbox_[makeSquare(rank, 7)] == rook && !(occupiedBB_ & ks_between) &&
+        !(attackersTo(makeSquare(rank, 5), occupiedBB_) & enemy) &&
+        !(attackersTo(makeSquare(rank, 6), occupiedBB_) & enemy))
+    {
+        moves.push_back(PackedMove(ksq, makeSquare(rank, 6), MOVE_CASTLING));
+    }
 
-    // 3. ポーンによる攻撃チェック
-    int pawn_dir = attackingWhite ? 1 : -1;
-    int pr = r + pawn_dir;
-    if (pr >= 0 && pr < 8)
+    // クイーンサイド (b列は空いていればよく、利きは問わない)
+    bool rook_qs_moved = white ? castlingRights.whiteRookQSidesMoved : castlingRights.blackRookQSidesMoved;
+    Bitboard qs_between = squareBB(makeSquare(rank, 1)) | squareBB(makeSquare(rank, 2)) | squareBB(makeSquare(rank, 3));
+    if (!rook_qs_moved && mailbox_[makeSquare(rank, 0)] == rook && !(occupiedBB_ & qs_between) &&
+        !(attackersTo(makeSquare(rank, 3), occupiedBB_) & enemy) &&
+        !(attackersTo(makeSquare(rank, 2), occupiedBB_) & enemy))
     {
-        int capture_cols[] = {c - 1, c + 1};
-        for (int pc : capture_cols)
+        moves.push_back(PackedMove(ksq, makeSquare(rank, 2), MOVE_CASTLING));
+    }
+}
+
+// -------------------------------------------------------------
+// perft (合法手の木の末端ノード数)
+// -------------------------------------------------------------
+
+std::uint64_t ChessGame::perft(bool white, int depth, PerftCache *cache)
+{
+    setSideToMove(white);
+    return perftInternal(depth, cache);
+}
+
+std::uint64_t ChessGame::perftInternal(int depth, PerftCache *cache)
+{
+    if (depth <= 0)
+        return 1;
+
+    std::uint64_t nodes = 0;
+    if (depth > 1 && cache && cache->probe(key_, depth, nodes))
+        return nodes;
+
+    MoveList moves;
+    generateLegalMoves(sideToMove_ == WHITE, GEN_ALL, moves);
+    // 最後の1手は指さずに数えるだけ
+    if (depth == 1)
+        return moves.size();
+
+    for (PackedMove m : moves)
+    {
+        UndoInfo undo;
+        makeMoveInternal(m, undo);
+        nodes += perftInternal(depth - 1, cache);
+        unmakeMoveInternal(m, undo);
+    }
+
+    if (cache)
+        cache->store(key_, depth, nodes);
+    return nodes;
+}
+
+// -------------------------------------------------------------
+// AI機能 (Minimax)
+// -------------------------------------------------------------
+
+// 色colorのポーンから見て前方 (白は上、黒は下) の段すべて
+static Bitboard forwardRowsBB(int color, int row)
+{
+    if (color == WHITE)
+        return row == 0 ? 0 : (~Bitboard(0) >> (64 - 8 * row));
+    return row == 7 ? 0 : (~Bitboard(0) << (8 * (row + 1)));
+}
+
+// 自分のファイルと左右のファイル
+static Bitboard adjacentFilesBB(int col)
+{
+    Bitboard files = fileBB(col);
+    if (col > 0)
+        files |= fileBB(col - 1);
+    if (col < 7)
+        files |= fileBB(col + 1);
+    return files;
+}
+
+// 評価関数 (白から見た値)
+// 駒の価値と位置的価値は makeMoveInternal/unmakeMoveInternal で差分更新しているので、
+// ここで盤面を走査するのはキング周辺の利きとパスポーンだけ
+int ChessGame::evaluate() const
+{
+    // ★ ビットベースのある3駒の終盤は勝敗が正確に分かる
+    int bitbaseScore;
+    if (bitbases_ && popcount(occupiedBB_) == 3 && evaluateBitbase(bitbaseScore))
+        return bitbaseScore;
+
+    // 駒の価値 + 位置的価値 (序中盤と終盤の値の組、差分更新)
+    Score score = psqScore_;
+
+    // キング安全性ボーナス: 相手キング周辺(5x5エリア)の利きのあるマス1つにつき10点 (終盤は2倍)
+    int attack_on_king[2] = {0, 0};
+    for (int color = WHITE; color <= BLACK; color++)
+    {
+        Bitboard enemyKing = pieceBB_[color ^ 1][KING];
+        if (enemyKing)
+            attack_on_king[color] = 10 * popcount(KingZone[lsb(enemyKing)] & attackedBy(color));
+    }
+    int attack = attack_on_king[WHITE] - attack_on_king[BLACK];
+    score += makeScore(attack, attack * 2);
+
+    // ★ 局面の進み具合で序中盤と終盤の値を補間する (境目で評価値が跳ばない)
+    // ポーン構造はポーンのハッシュ表から引く (ポーンが動いていなければ計算しない)
+    return taper(score, gamePhase()) + pawnEntry().score;
+}
+
+// 局面の進み具合 (初期局面で PHASE_MAX、昇格で超えた分は切り捨て)
+int ChessGame::gamePhase() const
+{
+    return std::min(phase_, PHASE_MAX);
+}
+
+// 3駒の終盤の評価値 (白から見た値、ビットベースに無い局面なら false)
+bool ChessGame::evaluateBitbase(int &score) const
+{
+    BitbaseResult result = probeBitbase();
+    if (result == BITBASE_UNKNOWN)
+        return false;
+    if (result == BITBASE_DRAW)
+    {
+        score = 0;
+        return true;
+    }
+
+    // 勝つ側が勝ちに近づく手を選べるように、ポーンは前へ、相手キングは盤の端へ、キング同士は近くへ
+    int strong = (result == BITBASE_WIN) ? sideToMove_ : (sideToMove_ ^ 1);
+    int strongKing = lsb(pieceBB_[strong][KING]);
+    int weakKing = lsb(pieceBB_[strong ^ 1][KING]);
+    int progress = 0;
+    if (pieceBB_[strong][PAWN])
+    {
+        int pawn = lsb(pieceBB_[strong][PAWN]);
+        progress += 20 * (strong == WHITE ? 7 - rowOf(pawn) : rowOf(pawn));
+    }
+    else
+        progress += 10 * std::max(std::abs(2 * rowOf(weakKing) - 7), std::abs(2 * colOf(weakKing) - 7));
+    int kingDistance = std::max(std::abs(rowOf(strongKing) - rowOf(weakKing)), std::abs(colOf(strongKing) - colOf(weakKing)));
+    progress += 5 * (7 - kingDistance);
+
+    score = (strong == WHITE) ? BITBASE_WIN_SCORE + progress : -(BITBASE_WIN_SCORE + progress);
+    return true;
+}
+
+// 現局面のポーン構造 (表に無ければ計算して書き込む)
+const PawnEntry &ChessGame::pawnEntry() const
+{
+    bool hit;
+    PawnEntry *entry = pawnTable_->probe(pawnKey_, hit);
+    if (!hit)
+    {
+        entry->key = pawnKey_;
+        entry->score = passedPawnScore(entry->passed);
+    }
+    return *entry;
+}
+
+// 色colorの駒が利いているマス全体
+Bitboard ChessGame::attackedBy(int color) const
+{
+    Bitboard attacks = 0;
+    Bitboard b = pieceBB_[color][PAWN];
+    while (b)
+        attacks |= Attacks::pawn[color][popLsb(b)];
+    b = pieceBB_[color][KNIGHT];
+    while (b)
+        attacks |= Attacks::knight[popLsb(b)];
+    b = pieceBB_[color][BISHOP] | pieceBB_[color][QUEEN];
+    while (b)
+        attacks |= Attacks::bishop(popLsb(b), occupiedBB_);
+    b = pieceBB_[color][ROOK] | pieceBB_[color][QUEEN];
+    while (b)
+        attacks |= Attacks::rook(popLsb(b), occupiedBB_);
+    b = pieceBB_[color][KING];
+    while (b)
+        attacks |= Attacks::king[popLsb(b)];
+    return attacks;
+}
+
+// 盤面を毎回走査する従来の評価関数 (差分更新版の検証用)
+int ChessGame::evaluateFullScan() const
+{
+    int mg = 0, eg = 0;
+    int phase = 0;
+
+    for (int color = WHITE; color <= BLACK; color++)
+    {
+        int sign = (color == WHITE) ? 1 : -1; // 白: 加算、黒: 減算
+        for (int type = PAWN; type <= KING; type++)
         {
-            if (pc >= 0 && pc < 8)
+            Bitboard b = pieceBB_[color][type];
+            while (b)
             {
-                Piece p = board[pr][pc];
-                if (p.type != '*' && p.isWhite == attackingWhite && std::toupper(p.type) == 'P')
-                    return true;
+                int sq = popLsb(b);
+
+                // ★位置的価値 (PSTs) の計算
+                // 白の駒はそのまま (r, c) を使い、黒の駒は盤面を上下反転して (7-r, c) を使う
+                int row_index = (color == WHITE) ? rowOf(sq) : (7 - rowOf(sq));
+                mg += sign * (PieceValues[type] + MgTables[type][row_index][colOf(sq)]);
+                eg += sign * (PieceValues[type] + EgTables[type][row_index][colOf(sq)]);
+                phase += PhaseWeight[type];
             }
         }
     }
 
-    // 4. 直線移動駒 (R, B, Q) による攻撃チェック
-    std::vector<std::pair<int, int>> sliding_dirs = {
-        {1, 0}, {-1, 0}, {0, 1}, {0, -1}, // R, Q
-        {1, 1},
-        {1, -1},
-        {-1, 1},
-        {-1, -1} // B, Q
-    };
-
-    for (const auto &dir : sliding_dirs)
+    // ★★★ 終盤のキング安全性ボーナス (汎用的な記述) ★★★
+    //-------------------------------------------
+    // attack_on_king[color]: colorが相手キング周辺(5x5エリア)のマスを攻撃している量
+    int attack_on_king[2] = {0, 0};
+    for (int color = WHITE; color <= BLACK; color++)
     {
-        int dr = dir.first, dc = dir.second;
-        int nr = r + dr, nc = c + dc;
-        char required_type = ((dr == 0 || dc == 0) && dr != dc) ? 'R' : 'B';
+        std::pair<int, int> kingPos = findKing(color != WHITE);
+        if (kingPos.first < 0)
+            continue;
 
-        while (nr >= 0 && nr < 8 && nc >= 0 && nc < 8)
+        for (int dr = -2; dr <= 2; dr++)
         {
-            Piece target = board[nr][nc];
-            if (target.type != '*')
+            for (int dc = -2; dc <= 2; dc++)
             {
-                if (target.isWhite == attackingWhite)
+                int nr = kingPos.first + dr;
+                int nc = kingPos.second + dc;
+                if (nr >= 0 && nr < 8 && nc >= 0 && nc < 8 && isSquareAttacked(nr, nc, color == WHITE))
                 {
-                    char upper_type = std::toupper(target.type);
-                    if (upper_type == 'Q')
-                        return true;
-                    if (required_type == 'R' && upper_type == 'R')
-                        return true;
-                    if (required_type == 'B' && upper_type == 'B')
-                        return true;
+                    attack_on_king[color] += 10;
                 }
-                break;
             }
-            nr += dr;
-            nc += dc;
         }
     }
-    return false;
+
+    // 白の攻撃ボーナスはプラス、黒の攻撃ボーナスはマイナス (終盤なら攻撃ボーナスを2倍に強める)
+    mg += attack_on_king[WHITE] - attack_on_king[BLACK];
+    eg += (attack_on_king[WHITE] - attack_on_king[BLACK]) * 2;
+
+    // 序中盤と終盤の値を局面の進み具合で補間する
+    phase = std::min(phase, PHASE_MAX);
+    int score = (mg * phase + eg * (PHASE_MAX - phase)) / PHASE_MAX;
+
+    Bitboard passed[2];
+    score += passedPawnScore(passed);
+
+    return score;
+}
+
+// 終盤のポーンプロモーションの脅威 (パスポーンのボーナス、白から見た値)
+// passed には色ごとのパスポーンの集合を返す
+int ChessGame::passedPawnScore(Bitboard passed[2]) const
+{
+    int passed_pawn_bonus = 0;
+
+    for (int color = WHITE; color <= BLACK; color++)
+    {
+        passed[color] = 0;
+        Bitboard enemyPawns = pieceBB_[color ^ 1][PAWN];
+        Bitboard pawns = pieceBB_[color][PAWN];
+        while (pawns)
+        {
+            int sq = popLsb(pawns);
+            int r = rowOf(sq);
+
+            // 自分と左右のファイルの前方に敵ポーンがいなければ Passed Pawn
+            if (enemyPawns & adjacentFilesBB(colOf(sq)) & forwardRowsBB(color, r))
+                continue;
+            passed[color] |= squareBB(sq);
+
+            // 昇格に近いほど大きなボーナスを与える
+            int rank_dist = (color == WHITE) ? (7 - r) : r;
+            int bonus = 10 + rank_dist * 20;
+
+            passed_pawn_bonus += (color == WHITE) ? bonus : -bonus;
+        }
+    }
+    return passed_pawn_bonus;
 }
 
 // -------------------------------------------------------------
-// 履歴保存と三回反復チェック
+// 静止探索 (Quiescence Search)
+// 探索の末端で駒の取り合いが終わるまで読み、水平線効果を防ぐ
 // -------------------------------------------------------------
 
-std::string ChessGame::getBoardStateFEN(bool turnWhite) const
+// 移動で得られる駒の価値 (取った駒 + 昇格による増分)
+int ChessGame::captureGain(PackedMove m) const
 {
-    std::string fen = "";
-    // 1. 駒の配置 (board[8][8] を 'rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR' の形式に変換)
-    //    ★この部分の実装が少し大変ですが、盤面をユニークに識別できます。
-    //    今回は簡易的に、全マスを繋げた文字列に色と権利情報を追加するだけでも可。
-    // 例: "rnbqkbnr...PPPPPPPP" + (turnWhite ? "w" : "b") + castling_rights_string
+    int to = m.to();
+    int gain = (mailbox_[to] != NO_PIECE) ? PieceValues[typeOf(mailbox_[to])] : 0;
+    if (m.kind() == MOVE_PROMOTION)
+        gain += PieceValues[m.promotion()] - PieceValues[PAWN];
+    return gain;
+}
 
-    // 2. 手番 (w or b) を追加
-    // 3. キャスリング権 (KQkqなど) を追加
-    // 4. アンパッサンターゲットマス (今回は省略可) を追加
-    // 5. 50手ルールカウント (今回は省略可) を追加
-    // 6. フルムーブ数 (今回は省略可) を追加
+// -------------------------------------------------------------
+// 静的交換評価 (Static Exchange Evaluation: SEE)
+// 移動先のマスに利いている駒で、両者が安い駒から順に取り返した場合の損得を求める
+// 各手番は「取り返す」か「やめる」を選べるので、最後から逆にたどって良い方を取る
+// 取った駒の後ろにいる走り駒 (X-ray) も順に加える。ピンは考えない
+// -------------------------------------------------------------
 
-    // 簡易版の例 (駒の配置と手番のみ):
-    for (int r = 0; r < 8; ++r)
+int ChessGame::see(PackedMove m) const
+{
+    if (m.kind() == MOVE_CASTLING)
+        return 0;
+
+    int from = m.from(), to = m.to();
+    int gain[32];
+    int d = 0;
+    gain[0] = captureGain(m);
+
+    // 移動先にいる (次に取られる) 駒
+    int onSquare = (m.kind() == MOVE_PROMOTION) ? m.promotion() : typeOf(mailbox_[from]);
+    int side = colorOf(mailbox_[from]) ^ 1;
+
+    const Bitboard(*p)[6] = pieceBB_;
+    const Bitboard diagonal = p[WHITE][BISHOP] | p[BLACK][BISHOP] | p[WHITE][QUEEN] | p[BLACK][QUEEN];
+    const Bitboard straight = p[WHITE][ROOK] | p[BLACK][ROOK] | p[WHITE][QUEEN] | p[BLACK][QUEEN];
+    Bitboard occupied = occupiedBB_ ^ squareBB(from);
+    Bitboard attackers = attackersTo(to, occupied) & occupied;
+
+    while (true)
     {
-        for (int c = 0; c < 8; ++c)
-        {
-            fen += board[r][c].type;
-        }
+        Bitboard ours = attackers & colorBB_[side];
+        if (!ours)
+            break;
+
+        // 一番安い駒で取り返す
+        int type = PAWN;
+        while (!(ours & p[side][type]))
+            type++;
+
+        // gain[d]: d 回目に取った側の、そこまでの損得
+        d++;
+        gain[d] = PieceValues[onSquare] - gain[d - 1];
+
+        onSquare = type;
+        occupied ^= squareBB(lsb(ours & p[side][type]));
+
+        // ★ X-ray: 動いた駒の後ろにいた走り駒が利くようになる
+        if (type == PAWN || type == BISHOP || type == QUEEN || type == KING)
+            attackers |= Attacks::bishop(to, occupied) & diagonal;
+        if (type == ROOK || type == QUEEN || type == KING)
+            attackers |= Attacks::rook(to, occupied) & straight;
+        attackers &= occupied;
+        side ^= 1;
+    }
+
+    // 最後の取り合いから逆にたどり、各手番は取り返すかやめるかの良い方を選ぶ
+    while (d > 0)
+    {
+        gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+        d--;
     }
-    fen += (turnWhite ? "w" : "b");
-    return fen;
+    return gain[0];
 }
 
-// chess_game.cpp に追加
-bool ChessGame::isDrawByThreefoldRepetition(bool turnWhite) const
+// see(m) >= threshold かどうかだけを求める (探索ではこちらを使う)
+// 「取り合いをここでやめた場合に threshold を超えるか」を交互に確かめ、決まった時点で打ち切る
+bool ChessGame::seeGe(PackedMove m, int threshold) const
 {
-    if (position_history_.empty())
+    if (m.kind() == MOVE_CASTLING)
+        return threshold <= 0;
+
+    int from = m.from(), to = m.to();
+    int moved = (m.kind() == MOVE_PROMOTION) ? m.promotion() : typeOf(mailbox_[from]);
+
+    // 取った駒だけでは足りない
+    int swap = captureGain(m) - threshold;
+    if (swap < 0)
         return false;
+    // 動いた駒を取り返されても足りる
+    swap = PieceValues[moved] - swap;
+    if (swap <= 0)
+        return true;
 
-    // 現在の盤面状態を取得
-    std::string current_state = getBoardStateFEN(turnWhite);
-    int count = 0;
+    const Bitboard(*p)[6] = pieceBB_;
+    const Bitboard diagonal = p[WHITE][BISHOP] | p[BLACK][BISHOP] | p[WHITE][QUEEN] | p[BLACK][QUEEN];
+    const Bitboard straight = p[WHITE][ROOK] | p[BLACK][ROOK] | p[WHITE][QUEEN] | p[BLACK][QUEEN];
+    Bitboard occupied = occupiedBB_ ^ squareBB(from);
+    Bitboard attackers = attackersTo(to, occupied);
+    int side = colorOf(mailbox_[from]);
+    int result = 1; // 1: 最初に動いた側の勝ち
+
+    while (true)
+    {
+        side ^= 1;
+        attackers &= occupied;
+        Bitboard ours = attackers & colorBB_[side];
+        if (!ours)
+            break;
+        result ^= 1;
+
+        int type = PAWN;
+        while (!(ours & p[side][type]))
+            type++;
+
+        // キングで取り返せるのは、相手にもう利いている駒が無い時だけ
+        if (type == KING)
+            return (attackers & colorBB_[side ^ 1]) ? !result : result;
+
+        swap = PieceValues[type] - swap;
+        if (swap < result)
+            break;
+
+        occupied ^= squareBB(lsb(ours & p[side][type]));
+        if (type == PAWN || type == BISHOP || type == QUEEN)
+            attackers |= Attacks::bishop(to, occupied) & diagonal;
+        if (type == ROOK || type == QUEEN)
+            attackers |= Attacks::rook(to, occupied) & straight;
+    }
+    return result;
+}
+
+int ChessGame::quiescence(int ply, int alpha, int beta)
+{
+    if (checkStop())
+    {
+        return 0;
+    }
+    qnodes_++;
+    selDepth_ = std::max(selDepth_, ply);
+
+    bool white = (sideToMove_ == WHITE);
+    bool isCheck = inCheck();
+
+    int bestEval;
+    int standPat = 0;
+
+    if (isCheck)
+    {
+        // 王手されている場合は「何もしない」選択肢が無いので、全ての応手を調べる
+        bestEval = -INF_SCORE;
+    }
+    else
+    {
+        // ★ Stand pat: 駒を取らずに止まった場合の評価値で打ち切る
+        standPat = white ? evaluate() : -evaluate();
+        if (standPat >= beta)
+            return standPat;
+        alpha = std::max(alpha, standPat);
+        bestEval = standPat;
+    }
 
-    // 履歴を逆順にチェックして、同じ状態が何回出現したか数える
-    for (const auto &state : position_history_)
+    // 王手されていなければ取る手だけを MVV-LVA 順に調べる
+    MovePicker picker(*this, white, isCheck);
+    PackedMove move;
+    int moveCount = 0;
+
+    while (picker.next(move))
     {
-        if (state == current_state)
+        moveCount++;
+        if (!isCheck)
         {
-            count++;
+            // ★ Delta pruning: 取った駒の価値を足しても alpha に届かない手は読まない
+            int gain = captureGain(move);
+            if (standPat + gain + QS_DELTA_MARGIN <= alpha)
+                continue;
+
+            // ★ 取り合いの結果が損になる手、取り合いの後の駒得を足しても alpha に届かない手は読まない (SEE)
+            if (!seeGe(move, std::max(0, alpha - standPat - QS_DELTA_MARGIN + 1)))
+                continue;
+        }
+
+        UndoInfo undo;
+        makeMoveInternal(move, undo);
+        int score = -quiescence(ply + 1, -beta, -alpha);
+        unmakeMoveInternal(move, undo);
+
+        if (stop_->load(std::memory_order_relaxed))
+        {
+            return 0;
+        }
+
+        if (score > bestEval)
+        {
+            bestEval = score;
+            if (score > alpha)
+                alpha = score;
+            if (alpha >= beta)
+                break;
         }
     }
 
-    // 3回以上出現したら引き分け
-    return count >= 3;
+    // 王手されていて応手が無い = チェックメイト
+    if (isCheck && moveCount == 0)
+    {
+        return -(MATE_SCORE - ply);
+    }
+
+    return bestEval;
+}
+
+// 枝刈りを起こした取らない手をキラー手・ヒストリーに記録する
+void ChessGame::updateQuietHeuristics(PackedMove m, int ply, int depth)
+{
+    if (killers_[ply][0] != m)
+    {
+        killers_[ply][1] = killers_[ply][0];
+        killers_[ply][0] = m;
+    }
+
+    // 深い探索での枝刈りほど重く数える (大きくなりすぎたら全体を半分にする)
+    int us = sideToMove_;
+    int &h = history_[us][m.from()][m.to()];
+    h += depth * depth;
+    if (h > HISTORY_MAX)
+    {
+        for (auto &side : history_)
+            for (auto &from : side)
+                for (int &value : from)
+                    value /= 2;
+    }
 }
 
 // -------------------------------------------------------------
-// 合法手生成
+// Negamax + PVS (Principal Variation Search)
+// 評価値は常に手番側から見た値 (白から見た値は bestMove で変換する)
 // -------------------------------------------------------------
 
-void ChessGame::generateSlidingMoves(int r, int c, bool white, char type, std::vector<Move> &moves) const
+// 手番側が王手されているか
+bool ChessGame::inCheck() const
+{
+    Bitboard kingBB = pieceBB_[sideToMove_][KING];
+    return kingBB && (attackersTo(lsb(kingBB), occupiedBB_) & colorBB_[sideToMove_ ^ 1]);
+}
+
+// ポーンとキング以外の駒を持っているか (無ければヌルムーブは危険)
+bool ChessGame::hasNonPawnMaterial(int color) const
 {
-    // ... (元の generateSlidingMoves のロジックをそのまま移植)
-    std::vector<std::pair<int, int>> directions;
-    if (type == 'R' || type == 'Q')
+    return (colorBB_[color] & ~pieceBB_[color][PAWN] & ~pieceBB_[color][KING]) != 0;
+}
+
+// パス (手番だけを相手に渡す)
+void ChessGame::makeNullMove(UndoInfo &undo)
+{
+    undo.rule50 = rule50_;
+    keyHistory_.push_back(key_);
+    rule50_ = 0; // パスの前後は同一局面にならないので、千日手の判定はここで区切る
+    sideToMove_ ^= 1;
+    key_ ^= Zobrist::side;
+}
+
+void ChessGame::unmakeNullMove(const UndoInfo &undo)
+{
+    sideToMove_ ^= 1;
+    key_ ^= Zobrist::side;
+    rule50_ = undo.rule50;
+    keyHistory_.pop_back();
+}
+
+int ChessGame::negamax(int depth, int ply, int alpha, int beta, bool allowNull)
+{
+    // 探索経路上またはゲームの履歴で同じ局面が現れたら千日手 (引き分け) とみなす
+    if (repetitionCount() > 0)
+    {
+        return 0;
+    }
+
+    // ★ 3駒の終盤はビットベースで勝敗が分かる
+    //   引き分けならそのまま返す。勝ち負けも、ルート局面がまだ3駒でなければ探索せずに評価値を返す
+    //   (ルートが既にその終盤なら、メイトまで読めるように探索を続ける)
+    if (ply > 0 && bitbases_ && popcount(occupiedBB_) == 3)
+    {
+        BitbaseResult result = probeBitbase();
+        if (result == BITBASE_DRAW)
+            return 0;
+        if (result != BITBASE_UNKNOWN && !rootInBitbase_)
+            return (sideToMove_ == WHITE) ? evaluate() : -evaluate();
+    }
+
+    // 1. 探索深さが0に達した場合
+    if (depth <= 0)
     {
-        directions.push_back({1, 0});
-        directions.push_back({-1, 0});
-        directions.push_back({0, 1});
-        directions.push_back({0, -1});
+        return quiescence(ply, alpha, beta); // 駒の取り合いが終わるまで読んでから評価
     }
-    if (type == 'B' || type == 'Q')
+
+    // 打ち切り条件に達したら結果は捨てられるので何を返してもよい
+    if (checkStop())
+    {
+        return 0;
+    }
+    selDepth_ = std::max(selDepth_, ply);
+
+    bool white = (sideToMove_ == WHITE);
+    bool pvNode = (beta - alpha > 1); // 窓が1より広い = 最善手順の候補を探しているノード
+    bool isCheck = inCheck();
+
+    // 2. 置換表を参照 (PVノード以外では、十分な深さで探索済みならそのまま返す)
+    const int alphaOrig = alpha;
+    TTData tte;
+    std::uint16_t ttMove = 0;
+    if (tt_->probe(key_, ply, tte, ttStats_))
     {
-        directions.push_back({1, 1});
-        directions.push_back({1, -1});
-        directions.push_back({-1, 1});
-        directions.push_back({-1, -1});
+        ttMove = tte.move;
+        if (!pvNode && tte.depth >= depth &&
+            (tte.bound == BOUND_EXACT ||
+             (tte.bound == BOUND_LOWER && tte.score >= beta) ||
+             (tte.bound == BOUND_UPPER && tte.score <= alpha)))
+        {
+            return tte.score;
+        }
     }
 
-    for (const auto &dir : directions)
+    // 3. ★ ヌルムーブ枝刈り
+    //    手番を相手に渡しても (= 1手パスしても) beta 以上なら、普通に指せばもっと良いはず
+    //    ポーンとキングだけの終盤はパスが最善になりうる (ツークツワンク) ので行わない
+    if (allowNull && !pvNode && !isCheck && depth >= NULL_MOVE_MIN_DEPTH && hasNonPawnMaterial(sideToMove_) &&
+        (white ? evaluate() : -evaluate()) >= beta)
     {
-        int dr = dir.first, dc = dir.second;
-        int nr = r + dr, nc = c + dc;
+        int R = (depth > 6) ? 3 : 2; // 深いほど大きく減らす
+        UndoInfo undo;
+        makeNullMove(undo);
+        int score = -negamax(depth - 1 - R, ply + 1, -beta, -beta + 1, false);
+        unmakeNullMove(undo);
 
-        while (nr >= 0 && nr < 8 && nc >= 0 && nc < 8)
+        if (stop_->load(std::memory_order_relaxed))
         {
-            Piece target = board[nr][nc];
-            if (target.type == '*')
-            {
-                moves.push_back({{r, c}, {nr, nc}});
-            }
-            else if (target.isWhite != white)
+            return 0;
+        }
+        if (score >= beta)
+        {
+            // パスして得たメイトのスコアは信用できない
+            return (score >= MATE_IN_MAX_PLY) ? beta : score;
+        }
+    }
+
+    // 4. 置換表の手 → 駒を取る手 → キラー手 → 取らない手 の順に、必要になった分だけ生成する
+    MovePicker picker(*this, white, PackedMove::fromRaw(ttMove), killers_[ply]);
+
+    int bestEval = -INF_SCORE;
+    PackedMove bestMoveHere = PACKED_MOVE_NONE;
+    PackedMove move;
+    int moveCount = 0;
+
+    while (picker.next(move))
+    {
+        bool quiet = isQuietMove(move);
+
+        // ★ 浅い深さでは、取り合いで大きく損をする駒取りを読まない (SEE)
+        //   最初の手は必ず読むので、全ての手を飛ばしてメイトと誤ることはない
+        //   飛ばした手は moveCount に数えない (LMR の「後ろの方の手」の判定がずれないように)
+        if (!pvNode && !isCheck && !quiet && moveCount > 0 && depth <= SEE_PRUNE_DEPTH &&
+            bestEval > -MATE_IN_MAX_PLY && !seeGe(move, -SEE_CAPTURE_MARGIN * depth))
+        {
+            continue;
+        }
+        moveCount++;
+
+        UndoInfo undo;
+        makeMoveInternal(move, undo);
+
+        int score;
+        if (moveCount == 1)
+        {
+            // 最初の手 (最善手の候補) は全幅の窓で読む
+            score = -negamax(depth - 1, ply + 1, -beta, -alpha, true);
+        }
+        else
+        {
+            // ★ Late Move Reductions: 後ろの方の取らない手は浅く読む
+            int R = 0;
+            if (depth >= LMR_MIN_DEPTH && moveCount > LMR_MIN_MOVES && quiet && !isCheck && !inCheck())
             {
-                moves.push_back({{r, c}, {nr, nc}});
-                break;
+                R = (moveCount > 2 * LMR_MIN_MOVES && depth >= 6) ? 2 : 1;
+                if (pvNode)
+                    R--;
             }
-            else
+
+            // ★ PVS: 残りの手は「alpha を超えるか」だけを幅0の窓で確かめる
+            score = -negamax(depth - 1 - R, ply + 1, -alpha - 1, -alpha, true);
+
+            // 浅く読んで alpha を超えたなら、元の深さで読み直す
+            if (R > 0 && score > alpha)
+                score = -negamax(depth - 1, ply + 1, -alpha - 1, -alpha, true);
+
+            // alpha を超えて beta 未満なら、全幅の窓で読み直して正確な値を求める
+            if (score > alpha && score < beta)
+                score = -negamax(depth - 1, ply + 1, -beta, -alpha, true);
+        }
+
+        unmakeMoveInternal(move, undo);
+
+        // 打ち切られた部分木の値は信用できないので、置換表にも保存しない
+        if (stop_->load(std::memory_order_relaxed))
+        {
+            return 0;
+        }
+
+        if (score > bestEval)
+        {
+            bestEval = score;
+            bestMoveHere = move;
+
+            if (score > alpha)
+                alpha = score; // ★ Alpha の更新
+
+            if (alpha >= beta) // ★ Cutoff (枝刈り)
             {
+                cutoffs_++;
+                if (moveCount == 1)
+                    firstMoveCutoffs_++;
+                if (quiet)
+                    updateQuietHeuristics(move, ply, depth);
                 break;
             }
-            nr += dr;
-            nc += dc;
         }
     }
+
+    // 5. 葉ノード (チェックメイト or ステールメイト) の判定
+    if (moveCount == 0)
+    {
+        // チェックメイト！ 手番側から見て最悪の値
+        // ルートからの手数 (ply) が少ないほど絶対値を大きくし、最短のメイトを優先させる
+        // ステールメイトは引き分けで0点
+        return isCheck ? -(MATE_SCORE - ply) : 0;
+    }
+
+    // 6. 置換表に保存 (元の窓に対して上限/下限/正確な値のどれか)
+    Bound bound = (bestEval <= alphaOrig) ? BOUND_UPPER : (bestEval >= beta) ? BOUND_LOWER : BOUND_EXACT;
+    tt_->store(key_, ply, bestEval, depth, bound, bestMoveHere.raw(), ttStats_);
+
+    return bestEval;
 }
 
-std::vector<Move> ChessGame::generateMoves(bool white) const
+// -------------------------------------------------------------
+// 反復深化
+// -------------------------------------------------------------
+
+double ChessGame::elapsedMs() const
 {
-    std::vector<Move> all_moves;
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime_).count();
+}
 
-    // 1. 全ての駒について**形式的に**動ける手を生成 (キャスリングを含む)
-    // (元の generateMoves の前半ロジックを移植)
-    for (int r = 0; r < 8; r++)
+// ノードを1つ数え、打ち切り条件に達したら停止フラグを立てる
+// (時計の確認は重いので1024ノードに1回だけ)
+bool ChessGame::checkStop()
+{
+    if (stop_->load(std::memory_order_relaxed))
     {
-        for (int c = 0; c < 8; c++)
+        return true;
+    }
+
+    nodes_++;
+    if ((nodes_ & 1023) == 0)
+    {
+        // 途中経過用に全スレッドの合計へ加える (毎ノードだとスレッド間の競合で遅くなる)
+        sharedNodes_->fetch_add(1024, std::memory_order_relaxed);
+        if (limits_.timeMs > 0 && !ponder_->load(std::memory_order_relaxed) && elapsedMs() >= limits_.timeMs)
         {
-            Piece p = board[r][c];
-            if (p.type == '*' || p.isWhite != white)
-                continue;
+            stop_->store(true, std::memory_order_relaxed);
+        }
+    }
+    if (limits_.nodes > 0 && nodes_ >= limits_.nodes)
+    {
+        stop_->store(true, std::memory_order_relaxed);
+    }
+    return stop_->load(std::memory_order_relaxed);
+}
 
-            char type = std::toupper(p.type);
-            int dir = white ? -1 : 1;
+// 深さ depth でルートの手 moves[first] 以降を (alpha, beta) の窓で調べる (値は手番側から見たもの)
+// (first より前の手は multi-PV で既に選んだ手なので調べない)
+// 2手目以降は最善手の値を下限にした幅0の窓で確かめ、超えた時だけ読み直す
+// 最善手は moves[first] に移す (他の手の順番は変えない)
+// 途中で打ち切られた場合は false (bestScore は使えない)
+bool ChessGame::searchRoot(int depth, int alpha, int beta, MoveList &moves, std::size_t first, int &bestScore)
+{
+    const int alphaOrig = alpha;
+    bestScore = -INF_SCORE;
+    std::size_t bestIndex = first;
 
-            if (type == 'P')
-            {
-                // ... ポーンの移動ロジック
-                int ni = r + dir;
-                if (ni >= 0 && ni < 8 && board[ni][c].type == '*')
-                {
-                    all_moves.push_back({{r, c}, {ni, c}});
-                }
-                bool isInitialPos = (white && r == 6) || (!white && r == 1);
-                int ni2 = r + 2 * dir;
-                int ni1 = r + dir;
-                if (isInitialPos && ni2 >= 0 && ni2 < 8 && board[ni1][c].type == '*' && board[ni2][c].type == '*')
-                {
-                    all_moves.push_back({{r, c}, {ni2, c}});
-                }
-                int capture_cols[] = {c - 1, c + 1};
-                for (int nc : capture_cols)
-                {
-                    if (ni >= 0 && ni < 8 && nc >= 0 && nc < 8)
-                    {
-                        Piece target = board[ni][nc];
-                        if (target.type != '*' && target.isWhite != white)
-                        {
-                            all_moves.push_back({{r, c}, {ni, nc}});
-                        }
-                    }
-                }
-            }
-            else if (type == 'K')
+    for (std::size_t i = first; i < moves.size(); i++)
+    {
+        UndoInfo undo;
+        makeMoveInternal(moves[i], undo);
+
+        int score;
+        if (i == first)
+        {
+            score = -negamax(depth - 1, 1, -beta, -alpha, true);
+        }
+        else
+        {
+            score = -negamax(depth - 1, 1, -alpha - 1, -alpha, true);
+            if (score > alpha && score < beta)
+                score = -negamax(depth - 1, 1, -beta, -alpha, true);
+        }
+
+        unmakeMoveInternal(moves[i], undo);
+
+        if (stop_->load(std::memory_order_relaxed))
+        {
+            return false;
+        }
+
+        if (score > bestScore)
+        {
+            bestScore = score;
+            bestIndex = i;
+            if (score > alpha)
+                alpha = score;
+            if (alpha >= beta)
+                break; // fail-high: 窓を広げて読み直すので残りの手は調べない
+        }
+    }
+
+    // fail-low の場合はどの手が最善か分からないので、順番はそのままにする
+    if (bestScore > alphaOrig)
+    {
+        std::rotate(moves.begin() + first, moves.begin() + bestIndex, moves.begin() + bestIndex + 1);
+    }
+    return true;
+}
+
+// 最善手と同じ値の手を集める (反復深化の後に一度だけ行う)
+// 各手を「最善手の値以上か」だけを調べる幅0の窓で読むので、全幅で読み直すより軽い
+void ChessGame::collectTiedMoves(int depth, int bestScore, const MoveList &moves, MoveList &tiedMoves)
+{
+    tiedMoves.clear();
+    tiedMoves.push_back(moves[0]);
+    for (std::size_t i = 1; i < moves.size(); i++)
+    {
+        UndoInfo undo;
+        makeMoveInternal(moves[i], undo);
+        int score = -negamax(depth - 1, 1, -bestScore, -bestScore + 1, true);
+        unmakeMoveInternal(moves[i], undo);
+
+        // 時間切れなら、それまでに確かめた手の中から選ぶ
+        if (stop_->load(std::memory_order_relaxed))
+        {
+            break;
+        }
+        if (score >= bestScore)
+        {
+            tiedMoves.push_back(moves[i]);
+        }
+    }
+}
+
+// 反復深化の本体 (完了した深さを返す)
+// threadId = 0 がメインスレッド、1以上は Lazy SMP の補助スレッド
+int ChessGame::iterativeDeepening(MoveList &moves, int maxDepth, int threadId, int &bestScore)
+{
+    // ★ 補助スレッドは、根の手の順番と開始する深さを少しずつずらす
+    //   (全スレッドが同じ順に読むと同じ部分木を重複して読むだけになる)
+    if (threadId > 0)
+    {
+        std::rotate(moves.begin(), moves.begin() + threadId % moves.size(), moves.end());
+    }
+
+    // ★ multi-PV: k 番目の候補手は、1〜k-1 番目に選んだ手を除いた残りの中の最善手として求める
+    //   置換表は全ての行で共有するので、2行目以降は前の行で読んだ局面を引けて速い
+    //   (補助スレッドは multiPv = 1 で読み、置換表を通して手伝うだけ)
+    std::size_t lineCount = std::min<std::size_t>(std::max(limits_.multiPv, 1), moves.size());
+    std::vector<int> scores(lineCount, 0);
+
+    bestScore = 0;
+    int completedDepth = 0;
+    for (int depth = 1 + (threadId & 1); depth <= maxDepth; depth++)
+    {
+        bool completed = true;
+        for (std::size_t line = 0; line < lineCount && completed; line++)
+        {
+            // ★ Aspiration window: 前回の値の近くに窓を絞って読み、外れたら広げて読み直す
+            int delta = ASPIRATION_WINDOW;
+            int alpha = -INF_SCORE, beta = INF_SCORE;
+            if (depth >= ASPIRATION_MIN_DEPTH && completedDepth > 0 && std::abs(scores[line]) < MATE_IN_MAX_PLY)
             {
-                // ... キングの移動ロジック
-                for (int dr = -1; dr <= 1; dr++)
-                {
-                    for (int dc = -1; dc <= 1; dc++)
-                    {
-                        if (dr == 0 && dc == 0)
-                            continue;
-                        int nr = r + dr, nc = c + dc;
-                        if (nr >= 0 && nr < 8 && nc >= 0 && nc < 8)
-                        {
-                            Piece target = board[nr][nc];
-                            if (target.type == '*' || target.isWhite != white)
-                            {
-                                all_moves.push_back({{r, c}, {nr, nc}});
-                            }
-                        }
-                    }
-                }
-                // キャスリング
-                int rank = white ? 7 : 0;
-                bool king_moved = white ? castlingRights.whiteKingMoved : castlingRights.blackKingMoved;
-                if (r == rank && c == 4 && !king_moved)
-                {
-                    // キングサイド
-                    bool rook_ks_moved = white ? castlingRights.whiteRookKSidesMoved : castlingRights.blackRookKSidesMoved;
-                    if (!rook_ks_moved && board[rank][5].type == '*' && board[rank][6].type == '*')
-                    {
-                        all_moves.push_back({{r, c}, {r, 6}});
-                    }
-                    // クイーンサイド
-                    bool rook_qs_moved = white ? castlingRights.whiteRookQSidesMoved : castlingRights.blackRookQSidesMoved;
-                    if (!rook_qs_moved && board[rank][1].type == '*' && board[rank][2].type == '*' && board[rank][3].type == '*')
-                    {
-                        all_moves.push_back({{r, c}, {r, 2}});
-                    }
-                }
+                alpha = scores[line] - delta;
+                beta = scores[line] + delta;
             }
-            else if (type == 'N')
+
+            int score;
+            while ((completed = searchRoot(depth, alpha, beta, moves, line, score)))
             {
-                // ... ナイトの移動ロジック
-                int knight_moves[8][2] = {{2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}};
-                for (int i = 0; i < 8; i++)
-                {
-                    int nr = r + knight_moves[i][0], nc = c + knight_moves[i][1];
-                    if (nr >= 0 && nr < 8 && nc >= 0 && nc < 8)
-                    {
-                        Piece target = board[nr][nc];
-                        if (target.type == '*' || target.isWhite != white)
-                        {
-                            all_moves.push_back({{r, c}, {nr, nc}});
-                        }
-                    }
-                }
+                if (score <= alpha)
+                    alpha = (delta > ASPIRATION_MAX) ? -INF_SCORE : std::max(score - delta, -INF_SCORE); // fail-low
+                else if (score >= beta)
+                    beta = (delta > ASPIRATION_MAX) ? INF_SCORE : std::min(score + delta, INF_SCORE); // fail-high
+                else
+                    break;
+                delta *= 2;
             }
-            else if (type == 'R' || type == 'B' || type == 'Q')
+            if (completed)
+                scores[line] = score;
+        }
+
+        if (!completed)
+        {
+            break; // 途中で打ち切った反復の結果は使わない
+        }
+
+        // 後の行の方が良い値になることもあるので、値の順に並べ直す (同じ値なら元の順)
+        for (std::size_t i = 1; i < lineCount; i++)
+        {
+            for (std::size_t k = i; k > 0 && scores[k] > scores[k - 1]; k--)
             {
-                generateSlidingMoves(r, c, white, type, all_moves);
+                std::swap(scores[k], scores[k - 1]);
+                std::swap(moves[k], moves[k - 1]);
             }
         }
+
+        bestScore = scores[0];
+        completedDepth = depth;
+        if (threadId == 0)
+        {
+            lineMoves_.assign(moves.begin(), moves.begin() + lineCount);
+            lineScores_ = scores;
+            for (std::size_t line = 0; line < lineCount; line++)
+                reportInfo(depth, scores[line], moves[line], int(line) + 1);
+        }
+
+        // メイトが見つかったらそれ以上深く読む必要はない
+        if (std::abs(bestScore) >= MATE_IN_MAX_PLY)
+        {
+            break;
+        }
+
+        // 次の反復は今回より時間がかかるので、残り時間が半分を切っていたら始めない (先読み中は続ける)
+        if (threadId == 0 && limits_.timeMs > 0 && !ponder_->load() && elapsedMs() * 2 > limits_.timeMs)
+        {
+            break;
+        }
     }
+    return completedDepth;
+}
 
-    // 2. 違法な手 (自ら王手になる手) の除外処理
-    std::vector<Move> safeMoves;
-    bool selfWhite = white;
-    bool opponentWhite = !white;
+// first から置換表の最善手をたどって最善手順を作る (置換表の統計には数えない)
+void ChessGame::extractPv(PackedMove first, int maxLength, std::vector<PackedMove> &pv)
+{
+    pv.clear();
+    UndoInfo undo[MAX_PLY];
+    PackedMove move = first;
 
-    for (const auto &move : all_moves)
+    while (!move.isNone() && (int)pv.size() < std::min(maxLength, MAX_PLY) &&
+           isMoveLegal(sideToMove_ == WHITE, move))
     {
-        Piece capturedPiece;
-        // AI探索用の移動関数を使用
-        ChessGame temp_game = *this; // 盤面状態をコピー
-        temp_game.makeMoveInternal(move, capturedPiece);
+        makeMoveInternal(move, undo[pv.size()]);
+        pv.push_back(move);
 
-        std::pair<int, int> kingPos = temp_game.findKing(selfWhite);
-        int kr = kingPos.first;
-        int kc = kingPos.second;
+        // 同じ局面に戻る手順は循環するのでそこで止める
+        if (repetitionCount() > 0)
+            break;
+        move = PackedMove::fromRaw(tt_->bestMove(key_));
+    }
 
-        bool isInCheck = temp_game.isSquareAttacked(kr, kc, opponentWhite);
+    for (int i = (int)pv.size() - 1; i >= 0; i--)
+        unmakeMoveInternal(pv[i], undo[i]);
+}
 
-        if (!isInCheck)
-        {
-            safeMoves.push_back(move);
-        }
-        // Undoは不要 (temp_game がスコープを抜けるため)
+// 反復が1つ完了するたびに、途中経過をコールバックとログファイルに渡す
+// score は手番側から見た値
+// ルートの手 move と、その値 score (手番側から見た値) から1行分の結果を作る
+PvLine ChessGame::makePvLine(PackedMove move, int score, int depth)
+{
+    PvLine line;
+    line.move = move.toMove();
+    line.score = (sideToMove_ == WHITE) ? score : -score;
+    if (std::abs(score) >= MATE_IN_MAX_PLY)
+    {
+        int moves = (MATE_SCORE - std::abs(score) + 1) / 2;
+        line.mateIn = (line.score > 0) ? moves : -moves;
     }
 
-    return safeMoves;
+    std::vector<PackedMove> pv;
+    extractPv(move, depth, pv);
+    for (PackedMove m : pv)
+        line.pv.push_back(moveToAlgebratic(m));
+    return line;
 }
 
-// -------------------------------------------------------------
-// AI機能 (Minimax)
-// -------------------------------------------------------------
-int ChessGame::evaluate() const
+// 非同期探索のコピーと呼び出し側 (先読みと解析など) が同時に書くので、1行ずつ排他して追記する
+struct InfoLog
 {
+    std::mutex mutex;
+    std::ofstream file;
 
-    // 終盤判定
-    bool is_endgame = true;
-    int pawnCount = 0;
-    for (int r = 0; r < 8; r++)
+    void append(const std::string &line)
     {
-        for (int c = 0; c < 8; c++)
-        {
-            char type = std::toupper(board[r][c].type);
-            if (type == 'P')
-            {
-                pawnCount++;
-            }
-        }
+        std::lock_guard<std::mutex> lock(mutex);
+        file << line << std::endl;
     }
-    if (pawnCount > 8)
-        is_endgame = false;
+};
 
-    int score = 0;
-    // 駒の物質的価値 (P:100, N/B:300, R:500, Q:900, K:1000000)
-    const int piece_values[] = {200, 300, 300, 500, 900, 10000000};
-    const char piece_chars[] = {'P', 'N', 'B', 'R', 'Q', 'K'};
+void ChessGame::reportInfo(int depth, int score, PackedMove best, int multiPv)
+{
+    if (!infoCallback_ && !infoLog_)
+        return;
+
+    SearchInfo info;
+    info.depth = depth;
+    info.multiPv = multiPv;
+    info.selDepth = std::max(selDepth_, depth);
+    info.timeMs = elapsedMs();
+    info.nodes = sharedNodes_->load(std::memory_order_relaxed) + (nodes_ & 1023);
+    info.nps = info.timeMs > 0 ? info.nodes * 1000.0 / info.timeMs : 0.0;
+
+    PvLine line = makePvLine(best, score, depth);
+    info.score = line.score;
+    info.mateIn = line.mateIn;
+    info.pv = std::move(line.pv);
+
+    info.ttHitRate = ttStats_.probes ? double(ttStats_.hits) / ttStats_.probes : 0.0;
+    info.hashfull = tt_->hashfull();
+    info.cutoffs = cutoffs_;
+    info.firstMoveCutoffs = firstMoveCutoffs_;
+
+    if (infoCallback_)
+        infoCallback_(info);
+    if (infoLog_)
+        infoLog_->append(info.toJson());
+}
 
-    for (int r = 0; r < 8; r++)
+bool ChessGame::setInfoLog(const std::string &path)
+{
+    if (path.empty())
     {
-        for (int c = 0; c < 8; c++)
-        {
-            Piece p = board[r][c];
-            if (p.type == '*')
-                continue;
+        infoLog_.reset();
+        return true;
+    }
+    auto log = std::make_shared<InfoLog>();
+    log->file.open(path, std::ios::app);
+    if (!log->file)
+        return false;
+    infoLog_ = log;
+    return true;
+}
 
-            int material_value = 0;
-            char upper_type = std::toupper(p.type);
+std::string SearchInfo::toJson() const
+{
+    char buf[512];
+    std::snprintf(buf, sizeof(buf),
+                  "{\"depth\":%d,\"multipv\":%d,\"seldepth\":%d,\"nodes\":%llu,\"nps\":%.0f,\"score\":%d,\"mate\":%d,"
+                  "\"tt_hit_rate\":%.4f,\"hashfull\":%d,\"cutoffs\":%llu,\"first_move_cutoffs\":%llu,\"time_ms\":%.1f,\"pv\":[",
+                  depth, multiPv, selDepth, (unsigned long long)nodes, nps, score, mateIn, ttHitRate, hashfull,
+                  (unsigned long long)cutoffs, (unsigned long long)firstMoveCutoffs, timeMs);
+
+    std::string json = buf;
+    for (std::size_t i = 0; i < pv.size(); i++)
+    {
+        if (i > 0)
+            json += ",";
+        json += "\"" + pv[i] + "\"";
+    }
+    json += "]}";
+    return json;
+}
 
-            // 物質的価値の計算
-            for (int i = 0; i < 6; ++i)
-            {
-                if (piece_chars[i] == upper_type)
-                {
-                    material_value = piece_values[i];
-                    break;
-                }
-            }
+Move ChessGame::bestMove(bool white)
+{
+    return bestMove(white, searchLimits_);
+}
 
-            // ------------------------------------------------
-            // ★位置的価値 (Positional Score) の計算 (PSTsの使用)
-            // ------------------------------------------------
-            int positional_bonus = 0;
-            const int (*table)[8] = nullptr;
+Move ChessGame::bestMove(bool white, const SearchLimits &limits)
+{
+    stop_->store(false);
+    ponder_->store(limits.ponder);
+    return search(white, limits);
+}
 
-            switch (upper_type)
-            {
-            case 'P':
-                table = PawnTable;
-                break;
-            case 'N':
-                table = KnightTable;
-                break;
-            case 'B':
-                table = BishopTable;
-                break;
-            case 'R':
-                table = RookTable;
-                break;
-            case 'Q':
-                table = QueenTable;
-                break;
-            case 'K':
-                table = KingTable;
-                break;
-            }
+// 探索の本体
+// 停止フラグはここでは戻さない (startSearch で、探索が始まる前に止められた場合もすぐ終わるように)
+Move ChessGame::search(bool white, const SearchLimits &limits)
+{
+    setSideToMove(white);
 
-            if (table)
-            {
-                // 白の駒はそのまま (r, c) を使い、黒の駒は盤面を上下反転して (7-r, c) を使う
-                int row_index = p.isWhite ? r : (7 - r);
-                positional_bonus = table[row_index][c];
+    MoveList moves;
+    generateLegalMoves(white, GEN_ALL, moves);
+    if (moves.empty())
+    {
+        return MOVE_NONE;
+    }
 
-                // ★★★ キングPSTの終盤反転 ★★★
-                if (upper_type == 'K' && is_endgame)
-                {
-                    // 終盤でキングが中央に出るように評価を反転させる
-                    positional_bonus = -positional_bonus;
-                }
-            }
-            // ------------------------------------------------
+    // ★ オープニングブックにある局面では探索しない
+    //   使わなかった思考時間は貯めておき、ブックを抜けた後の手に回す
+    // (multi-PV の解析では候補手の評価値が欲しいので、ブックは引かない)
+    PackedMove bookMove = (limits.multiPv > 1) ? PACKED_MOVE_NONE : pickBookMove(moves);
+    if (!bookMove.isNone())
+    {
+        lastSearch_ = SearchStats();
+        lastSearch_.bookMove = true;
+        if (bookOptions_.bankTime && limits.timeMs > 0 && !limits.ponder)
+            bookTimeBank_->fetch_add(limits.timeMs);
+        return bookMove.toMove();
+    }
 
-            if (p.isWhite)
-            {
-                // 白: スコアに加算
-                score += material_value + positional_bonus;
-            }
-            else
-            {
-                // 黒: スコアから減算
-                score -= (material_value + positional_bonus);
-            }
-        }
+    // 探索の準備
+    // 置換表の世代を進める (前回の探索結果は残るが置き換えやすくなる)
+    tt_->newSearch();
+    limits_ = limits;
+    if (bookOptions_.bankTime && limits_.timeMs > 0)
+    {
+        // 貯めた時間から、1手あたり元の思考時間と同じだけまで足す
+        int bank = bookTimeBank_->load();
+        int bonus = 0;
+        do
+            bonus = std::min(bank, limits_.timeMs);
+        while (bonus > 0 && !bookTimeBank_->compare_exchange_weak(bank, bank - bonus));
+        limits_.timeMs += bonus;
+    }
+    nodes_ = 0;
+    qnodes_ = 0;
+    cutoffs_ = 0;
+    firstMoveCutoffs_ = 0;
+    ttStats_ = TranspositionTable::Stats();
+    selDepth_ = 0;
+    sharedNodes_->store(0);
+    rootInBitbase_ = (probeBitbase() != BITBASE_UNKNOWN);
+    lineMoves_.clear();
+    lineScores_.clear();
+
+    // キラー手は局面が変わると役に立たないので消し、ヒストリーは半分に減らして残す
+    for (auto &killers : killers_)
+        killers[0] = killers[1] = PACKED_MOVE_NONE;
+    for (auto &side : history_)
+        for (auto &from : side)
+            for (int &value : from)
+                value /= 2;
+    startTime_ = std::chrono::steady_clock::now();
+    lastSearch_ = SearchStats();
+    PawnHashTable::Stats pawnStatsBefore = pawnTable_->stats();
+
+    int maxDepth = (limits.depth > 0) ? std::min(limits.depth, MAX_PLY) : MAX_PLY;
+
+    // 合法手が1つなら探索しない (multi-PV の解析では評価値を出すために読む)
+    if (moves.size() == 1 && limits.multiPv <= 1)
+    {
+        maxDepth = 0;
     }
 
-    // ★★★ 終盤のキング安全性ボーナス (汎用的な記述) ★★★
-    //-------------------------------------------
+    // ★ Lazy SMP: 補助スレッドは盤面ごとコピーした自分の探索状態で同じ局面を読む
+    //   結果は共有している置換表を通してだけメインスレッドに伝わる
+    //   打ち切り条件はメインスレッドだけが判定し、停止フラグで補助スレッドも止める
+    std::vector<std::unique_ptr<ChessGame>> helpers;
+    std::vector<std::thread> helperThreads;
+    for (int i = 1; i < threads_ && maxDepth > 1; i++)
+    {
+        helpers.push_back(std::make_unique<ChessGame>(*this));
+        helpers.back()->limits_ = SearchLimits();
+        helpers.back()->pawnTable_ = std::make_shared<PawnHashTable>(pawnTable_->sizeKB()); // ポーンの表は共有しない
+    }
+    for (std::size_t i = 0; i < helpers.size(); i++)
+    {
+        ChessGame *helper = helpers[i].get();
+        int threadId = int(i) + 1;
+        helperThreads.emplace_back([helper, moves, maxDepth, threadId]() mutable
+                                   {
+                                       int score;
+                                       helper->iterativeDeepening(moves, maxDepth, threadId, score);
+                                   });
+    }
 
-    // White's Attack Score (白が黒キングを攻撃)
-    std::pair<int, int> blackKingPos = findKing(false);
-    int white_attack_on_black = 0;
+    // どの時点で止まっても合法手を返せるように、まずは先頭の手を最善手にしておく
+    // (searchRoot は最善手を先頭に移すので、次の反復ではその手から調べることになる)
+    int bestScore = 0;
+    int completedDepth = iterativeDeepening(moves, maxDepth, 0, bestScore);
+    lastSearch_.depth = completedDepth;
+    lastSearch_.score = white ? bestScore : -bestScore; // 白から見た値
 
-    // 相手キング周辺のマス(5x5エリア)が攻撃されているかチェック
-    for (int dr = -2; dr <= 2; dr++)
+    // 同点の手があればランダムに選ぶ (メイトの場合は最短のものを、multi-PV の解析では1番目の手をそのまま指す)
+    PackedMove best_move = moves[0];
+    if (completedDepth > 0 && std::abs(bestScore) < MATE_IN_MAX_PLY && !stop_->load() && limits_.multiPv <= 1)
     {
-        for (int dc = -2; dc <= 2; dc++)
-        {
-            int nr = blackKingPos.first + dr;
-            int nc = blackKingPos.second + dc;
-            if (nr >= 0 && nr < 8 && nc >= 0 && nc < 8)
-            {
-                // 黒キング周辺のマスを白（攻撃側）が攻撃しているか
-                if (isSquareAttacked(nr, nc, true))
-                {
-                    white_attack_on_black += 10;
-                }
-            }
-        }
+        MoveList tiedMoves;
+        collectTiedMoves(completedDepth, bestScore, moves, tiedMoves);
+        best_move = tiedMoves[std::rand() % tiedMoves.size()];
     }
 
-    // Black's Attack Score (黒が白キングを攻撃)
-    std::pair<int, int> whiteKingPos = findKing(true);
-    int black_attack_on_white = 0;
+    // 補助スレッドを止めて、ノード数と置換表の統計を合計する
+    stop_->store(true);
+    for (std::thread &t : helperThreads)
+        t.join();
 
-    for (int dr = -2; dr <= 2; dr++)
+    lastSearch_.nodes = nodes_;
+    lastSearch_.qnodes = qnodes_;
+    lastSearch_.tt = ttStats_;
+    for (const auto &helper : helpers)
     {
-        for (int dc = -2; dc <= 2; dc++)
-        {
-            int nr = whiteKingPos.first + dr;
-            int nc = whiteKingPos.second + dc;
-            if (nr >= 0 && nr < 8 && nc >= 0 && nc < 8)
-            {
-                // 白キング周辺のマスを黒（攻撃側）が攻撃しているか
-                if (isSquareAttacked(nr, nc, false))
-                {
-                    black_attack_on_white += 10;
-                }
-            }
-        }
+        lastSearch_.nodes += helper->nodes_;
+        lastSearch_.qnodes += helper->qnodes_;
+        lastSearch_.tt += helper->ttStats_;
     }
+    lastSearch_.cutoffs = cutoffs_;
+    lastSearch_.firstMoveCutoffs = firstMoveCutoffs_;
+    lastSearch_.pawnProbes = pawnTable_->stats().probes - pawnStatsBefore.probes;
+    lastSearch_.pawnHits = pawnTable_->stats().hits - pawnStatsBefore.hits;
+    lastSearch_.timeMs = elapsedMs();
+
+    // 相手の応手の予想 (指した後の局面を先読みするのに使う)
+    std::vector<PackedMove> pv;
+    extractPv(best_move, 2, pv);
+    if (pv.size() >= 2)
+        lastSearch_.ponderMove = pv[1].toMove();
+
+    if (limits_.multiPv > 1)
+    {
+        for (std::size_t i = 0; i < lineMoves_.size(); i++)
+            lastSearch_.lines.push_back(makePvLine(lineMoves_[i], lineScores_[i], completedDepth));
+    }
+    return best_move.toMove();
+}
 
-    // 攻撃ボーナスのウェイト調整
-    int weight = is_endgame ? 2 : 1; // 終盤なら攻撃ボーナスを強める
-
-    // 最終スコアに反映:
-    // 白の攻撃ボーナスは score にプラス (白の有利)
-    score += white_attack_on_black * weight;
+// -------------------------------------------------------------
+// オープニングブック
+// -------------------------------------------------------------
 
-    // 黒の攻撃ボーナスは score からマイナス (黒の有利 = 白の不利)
-    score -= black_attack_on_white * weight;
+bool ChessGame::openBook(const std::string &path, const BookOptions &options)
+{
+    std::shared_ptr<PolyglotBook> book;
+    if (!path.empty())
+    {
+        book = std::make_shared<PolyglotBook>();
+        if (!book->open(path))
+            book.reset();
+    }
+    setBook(book, options);
+    return book != nullptr;
+}
 
-    // ★★★ 終盤のポーンプロモーションの脅威 ★★★
-    //-------------------------------------------
-    int passed_pawn_bonus = 0;
+void ChessGame::setBook(std::shared_ptr<const PolyglotBook> book, const BookOptions &options)
+{
+    book_ = std::move(book);
+    bookOptions_ = options;
+    bookTimeBank_->store(0);
+}
 
-    for (int r = 0; r < 8; r++)
-    {
-        for (int c = 0; c < 8; c++)
-        {
-            Piece p = board[r][c];
-            if (std::toupper(p.type) == 'P')
-            {
-                bool isWhite = p.isWhite;
-                bool isPassed = true;
+Key ChessGame::bookKey() const
+{
+    if (!book_)
+        return 0;
+
+    // Polyglot ではキングとルークが元のマスにある場合だけキャスリング権を数える
+    // アンパサンの列は、手番側のポーンが2マス進んだポーンの隣にいる (取れる形の) 場合だけ数える
+    // (このプログラムはアンパサンを指さないが、キーは他のプログラムで作ったブックと合わせる)
+    int epFile = -1;
+    if (epSquare_ != NO_SQUARE && (Attacks::pawn[sideToMove_ ^ 1][epSquare_] & pieceBB_[sideToMove_][PAWN]))
+        epFile = colOf(epSquare_);
+    return book_->key(mailbox_, castlingIndexOnBoard(), epFile, sideToMove_ == WHITE);
+}
 
-                // ポーンの進行方向 (白は上: -1, 黒は下: +1)
-                int dir = isWhite ? -1 : 1;
+PackedMove ChessGame::probeBook() const
+{
+    MoveList moves;
+    generateLegalMoves(sideToMove_ == WHITE, GEN_ALL, moves);
+    return pickBookMove(moves);
+}
 
-                // ポーンのいるファイル(c)とその左右のファイル(c-1, c+1)をチェック
-                for (int check_c = c - 1; check_c <= c + 1; check_c++)
-                {
-                    if (check_c < 0 || check_c > 7)
-                        continue;
-
-                    // ポーンの前方すべてのマスをチェック
-                    for (int check_r = r + dir; check_r != (isWhite ? -1 : 8); check_r += dir)
-                    {
-                        Piece target = board[check_r][check_c];
-                        // 敵のポーンが前方にいれば、Passed Pawnではない
-                        if (std::toupper(target.type) == 'P' && target.isWhite != isWhite)
-                        {
-                            isPassed = false;
-                            break;
-                        }
-                    }
-                    if (!isPassed)
-                        break;
-                }
+// ブックの手のうち合法なもの (このプログラムが指せるもの) から1つ選ぶ
+PackedMove ChessGame::pickBookMove(const MoveList &legalMoves) const
+{
+    if (!book_ || !book_->isOpen() || gamePly_ > bookOptions_.maxPly)
+        return PACKED_MOVE_NONE;
 
-                if (isPassed)
-                {
-                    // 昇格に近いほど大きなボーナスを与える
-                    // 白: r=0 (1段目) に近いほど高得点。黒: r=7 (8段目) に近いほど高得点。
-                    int rank_dist = isWhite ? (7 - r) : r; // 1段目から数えて何段目か (r=7/0で0, r=0/7で7)
-                    // 10 + rank_dist * 20 程度のボーナス
-                    int bonus = 10 + rank_dist * 20;
+    std::size_t first, last;
+    book_->find(bookKey(), first, last);
 
-                    passed_pawn_bonus += isWhite ? bonus : -bonus;
-                }
-            }
+    PackedMove candidates[MAX_MOVES];
+    int weights[MAX_MOVES];
+    int count = 0, totalWeight = 0;
+    for (std::size_t i = first; i < last && count < MAX_MOVES; i++)
+    {
+        BookEntry e = book_->entry(i);
+        if (e.weight == 0 || e.weight < bookOptions_.minWeight)
+            continue;
+
+        int from, to, promotion;
+        PolyglotBook::decodeMove(e.move, from, to, promotion);
+        int piece = mailbox_[from];
+        if (piece == NO_PIECE)
+            continue;
+
+        PackedMove m;
+        if (typeOf(piece) == KING && mailbox_[to] == makePiece(colorOf(piece), ROOK))
+        {
+            // キャスリング (キングがルークのマスへ動く手) -> キングの移動先
+            m = PackedMove(from, makeSquare(rowOf(from), colOf(to) > colOf(from) ? 6 : 2), MOVE_CASTLING);
         }
+        else if (promotion != PolyglotBook::NO_PIECE_TYPE)
+            m = PackedMove(from, to, MOVE_PROMOTION, promotion); // クイーン以外への昇格は合法手に無いので除かれる
+        else
+            m = PackedMove(from, to);
+
+        if (!legalMoves.contains(m))
+            continue;
+        candidates[count] = m;
+        weights[count] = e.weight;
+        totalWeight += e.weight;
+        count++;
     }
-    score += passed_pawn_bonus;
+    if (count == 0)
+        return PACKED_MOVE_NONE;
 
-    return score;
-    return score;
-}
+    if (bookOptions_.bestOnly)
+        return candidates[std::max_element(weights, weights + count) - weights];
 
-int ChessGame::minimax(int depth, bool isMaximizingPlayer, int alpha, int beta)
-{ // 1. 探索深さが0に達した場合
-    if (depth == 0)
+    // 重みに比例してランダムに選ぶ
+    int r = std::rand() % totalWeight;
+    for (int i = 0; i < count; i++)
     {
-        return evaluate(); // 駒得・位置的価値で評価
+        if (r < weights[i])
+            return candidates[i];
+        r -= weights[i];
     }
+    return candidates[count - 1];
+}
 
-    // 2. 合法手を生成
-    // constメソッド generateMoves を呼び出し
-    auto moves = generateMoves(isMaximizingPlayer);
+// -------------------------------------------------------------
+// 終盤のビットベース
+// -------------------------------------------------------------
 
-    // 3. 葉ノード (チェックメイト or ステールメイト) の判定
-    if (moves.empty())
+int ChessGame::loadBitbases(const std::string &dir)
+{
+    auto bitbases = std::make_shared<Bitbases>();
+    int loaded = bitbases->load(dir);
+    bitbases_ = loaded > 0 ? bitbases : nullptr;
+    return loaded;
+}
+
+BitbaseResult ChessGame::probeBitbase() const
+{
+    if (!bitbases_ || popcount(occupiedBB_) != 3 || !pieceBB_[WHITE][KING] || !pieceBB_[BLACK][KING])
+        return BITBASE_UNKNOWN;
+
+    for (int color = WHITE; color <= BLACK; color++)
     {
-        // 自分のキングの位置を確認
-        std::pair<int, int> kingPos = findKing(isMaximizingPlayer);
-        // 相手からの攻撃を受けているか？
-        bool isCheck = isSquareAttacked(kingPos.first, kingPos.second, !isMaximizingPlayer);
+        // キング + ナイト/ビショップ1つではメイトできない
+        if (pieceBB_[color][KNIGHT] | pieceBB_[color][BISHOP])
+            return BITBASE_DRAW;
 
-        if (isCheck)
-        {
-            // チェックメイト！ 最大化側は極めて大きなプラス、最小化側は極めて大きなマイナス
-            // キングの価値(1000000000)をベースに、深さで少し調整して最短ルートを優先させる
-            int CHECKMATE_SCORE = 999999000; // キングの価値より少し低く設定
-            // 深さが残っているほど(depthが大きいほど)、より「早く」チェックメイトできることを意味する
-            return isMaximizingPlayer ? (CHECKMATE_SCORE + depth) : -(CHECKMATE_SCORE + depth);
-        }
-        else
+        const int types[3] = {PAWN, ROOK, QUEEN};
+        for (int type : types)
         {
-            // ステールメイト
-            return 0; // 引き分けは0点
+            if (pieceBB_[color][type])
+                return bitbases_->probe(type, color, sideToMove_, lsb(pieceBB_[color][KING]),
+                                        lsb(pieceBB_[color ^ 1][KING]), lsb(pieceBB_[color][type]));
         }
     }
+    return BITBASE_UNKNOWN;
+}
 
-    if (isMaximizingPlayer)
-    {
-        int maxEval = -2000000;
-        for (const auto &move : moves)
-        {
-            Piece capturedPiece;
-            makeMoveInternal(move, capturedPiece);
-            // 評価関数の呼び出しにも alpha, beta を渡す
-            int evaluation = minimax(depth - 1, false, alpha, beta);
-            unmakeMoveInternal(move, capturedPiece);
-
-            maxEval = std::max(maxEval, evaluation);
-            alpha = std::max(alpha, maxEval); // ★ Alpha の更新
+// -------------------------------------------------------------
+// 非同期探索
+// -------------------------------------------------------------
 
-            if (beta <= alpha) // ★ Beta Cutoff (枝刈り)
-            {
-                break;
-            }
-        }
-        return maxEval;
-    }
-    else // isMinimizingPlayer
-    {
-        int minEval = 2000000;
-        for (const auto &move : moves)
-        {
-            Piece capturedPiece;
-            makeMoveInternal(move, capturedPiece);
-            // 評価関数の呼び出しにも alpha, beta を渡す
-            int evaluation = minimax(depth - 1, true, alpha, beta);
-            unmakeMoveInternal(move, capturedPiece);
+struct SearchHandle::State
+{
+    std::unique_ptr<ChessGame> game; // 呼び出し元の盤面のコピー (探索スレッドだけが触る)
+    std::thread thread;
+    std::atomic<bool> done{false};
+    Move best = MOVE_NONE;
+    SearchStats stats;
+};
 
-            minEval = std::min(minEval, evaluation);
-            beta = std::min(beta, minEval); // ★ Beta の更新
+SearchHandle::SearchHandle() = default;
+SearchHandle::SearchHandle(SearchHandle &&other) noexcept = default;
 
-            if (beta <= alpha) // ★ Alpha Cutoff (枝刈り)
-            {
-                break;
-            }
-        }
-        return minEval;
+SearchHandle &SearchHandle::operator=(SearchHandle &&other) noexcept
+{
+    if (this != &other)
+    {
+        // 前の探索は止めてから手放す
+        stop();
+        wait();
+        state_ = std::move(other.state_);
     }
+    return *this;
 }
 
-Move ChessGame::bestMove(bool white)
+SearchHandle::~SearchHandle()
 {
-    auto moves = generateMoves(white);
-    if (moves.empty())
-    {
-        return {{0, 0}, {0, 0}};
-    }
+    stop();
+    wait();
+}
 
-    int bestScore = white ? -20000000 : 20000000;
-    Move best_move = moves[0];
-    std::vector<Move> tiedMoves;
+void SearchHandle::stop()
+{
+    if (state_)
+        state_->game->stopSearch();
+}
 
-    for (const auto &move : moves)
-    {
-        Piece capturedPiece;
-        makeMoveInternal(move, capturedPiece);
+void SearchHandle::ponderHit()
+{
+    if (state_)
+        state_->game->ponderHit();
+}
 
-        const int INF = 25000000; // 評価関数の最大値より大きい値
-        int score = minimax(MAX_DEPTH - 1, !white, -INF, INF);
+void SearchHandle::wait()
+{
+    if (state_ && state_->thread.joinable())
+        state_->thread.join();
+}
 
-        unmakeMoveInternal(move, capturedPiece);
+bool SearchHandle::ready() const
+{
+    return !state_ || state_->done.load();
+}
 
-        if (white)
-        {
-            if (score > bestScore)
-            {
-                bestScore = score;
-                tiedMoves.clear();
-                tiedMoves.push_back(move);
-            }
-            else if (score == bestScore)
-            {
-                tiedMoves.push_back(move);
-            }
-        }
-        else
-        {
-            if (score < bestScore)
-            {
-                bestScore = score;
-                tiedMoves.clear();
-                tiedMoves.push_back(move);
-            }
-            else if (score == bestScore)
-            {
-                tiedMoves.push_back(move);
-            }
-        }
-    }
+Move SearchHandle::get()
+{
+    wait();
+    return state_ ? state_->best : MOVE_NONE;
+}
 
-    if (!tiedMoves.empty())
-    {
-        return tiedMoves[std::rand() % tiedMoves.size()];
-    }
-    return best_move;
+const SearchStats &SearchHandle::stats()
+{
+    static const SearchStats empty;
+    wait();
+    return state_ ? state_->stats : empty;
+}
+
+SearchHandle ChessGame::startSearch(bool white, const SearchLimits &limits, SearchCallbacks callbacks) const
+{
+    SearchHandle handle;
+    handle.state_ = std::make_unique<SearchHandle::State>();
+    SearchHandle::State *state = handle.state_.get();
+
+    // 盤面・探索状態はコピーし、置換表以外は共有しない
+    // (停止フラグも別にするので、このオブジェクトの stopSearch() や探索とは干渉しない)
+    state->game = std::make_unique<ChessGame>(*this);
+    ChessGame *game = state->game.get();
+    game->stop_ = std::make_shared<std::atomic<bool>>(false);
+    game->ponder_ = std::make_shared<std::atomic<bool>>(limits.ponder);
+    game->sharedNodes_ = std::make_shared<std::atomic<std::uint64_t>>(0);
+    game->pawnTable_ = std::make_shared<PawnHashTable>(pawnTable_->sizeKB());
+    game->infoCallback_ = std::move(callbacks.onInfo);
+
+    state->thread = std::thread([state, game, white, limits, onDone = std::move(callbacks.onDone)]()
+                                {
+                                    state->best = game->search(white, limits);
+                                    state->stats = game->lastSearch();
+                                    state->done.store(true);
+                                    if (onDone)
+                                        onDone(state->best, state->stats);
+                                });
+    return handle;
 }
 
 // -------------------------------------------------------------
@@ -1023,18 +2093,7 @@ void ChessGame::initBoard()
     std::string rows[8] = {
         "rnbqkbnr", "pppppppp", "********", "********",
         "********", "********", "PPPPPPPP", "RNBQKBNR"};
-    for (int i = 0; i < 8; i++)
-    {
-        for (int j = 0; j < 8; j++)
-        {
-            char c = rows[i][j];
-            if (c == '*')
-                board[i][j] = Piece('*', true);
-            else
-                board[i][j] = Piece(c, std::isupper(c));
-        }
-    }
-    castlingRights = {}; // 構造体のリセット
+    initBoardWithStrings(rows); // キャスリング権もリセットされる
 }
 
 Move ChessGame::ask(bool turnWhite)
@@ -1073,7 +2132,8 @@ Move ChessGame::ask(bool turnWhite)
         std::cout << "Illegal move. Try again.\n";
         return ask(turnWhite);
     }
-    if (board[start_r][start_c].type == '*' || board[start_r][start_c].isWhite != turnWhite)
+    int start_piece = mailbox_[makeSquare(start_r, start_c)];
+    if (start_piece == NO_PIECE || (colorOf(start_piece) == WHITE) != turnWhite)
     {
         std::cout << "No valid piece of your color on the starting square. Try again.\n";
         return ask(turnWhite);
@@ -1084,7 +2144,7 @@ Move ChessGame::ask(bool turnWhite)
 void ChessGame::runGame()
 {
     std::cout << "--- Full Chess (Minimax AI): Human (White) vs AI (Black) ---\n";
-    std::cout << "AI Depth: " << MAX_DEPTH << " (3-ply search).\n";
+    std::cout << "AI Time: " << searchLimits_.timeMs << " ms per move (iterative deepening).\n";
     std::cout << "Note: En Passant is NOT implemented. (Promotion and Checkmate/Stalemate are included.)\n";
     printBoard();
 
@@ -1160,24 +2220,80 @@ void ChessGame::runGame()
 // -------------------------------------------------------------
 
 /**
- * グローバル変数 board を引数の盤面設定で初期化する
+ * 盤面 (ビットボード) を引数の盤面設定で初期化する
  * 注意: この関数はグローバルの castlingRights も初期状態にリセットします
  */
 void ChessGame::initBoardWithStrings(const std::string rows[8])
 {
+    // キャスリング権を初期状態にリセット (より厳密には引数で受け取るべき)
+    castlingRights = {};
+
+    // 盤面・手番 (白)・キー履歴もリセットされる
+    clearBoard();
     for (int i = 0; i < 8; i++)
     {
-        for (int j = 0; j < 8; j++)
+        for (int j = 0; j < 8 && j < (int)rows[i].size(); j++)
         {
-            char c = rows[i][j];
-            if (c == '*')
-                board[i][j] = Piece('*', true);
-            else
-                board[i][j] = Piece(c, std::isupper(c));
+            // '*' や不明な文字は空マスとして扱う
+            int piece = charToPiece(rows[i][j]);
+            if (piece != NO_PIECE)
+                putPiece(piece, makeSquare(i, j));
         }
     }
-    // キャスリング権を初期状態にリセット (より厳密には引数で受け取るべき)
+}
+
+/**
+ * FEN文字列 (例: "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1") で盤面を設定する
+ * 手番より後ろのフィールドは省略してよい (省略時は白番・キャスリング権なし・手数1)
+ */
+bool ChessGame::setFen(std::string_view fen)
+{
+    FenPosition pos;
+    if (!parseFen(fen, pos))
+        return false;
+    setPosition(pos);
+    return true;
+}
+
+std::string_view ChessGame::fen(FenBuffer &buffer) const
+{
+    FenPosition pos;
+    getPosition(pos);
+    return writeFen(pos, buffer);
+}
+
+void ChessGame::setPosition(const FenPosition &pos)
+{
+    // キャスリング権は clearBoard でキーに入るので先に設定する (無い側は「動いた」ことにする)
     castlingRights = {};
+    castlingRights.whiteRookKSidesMoved = !(pos.castling & CASTLE_WHITE_K);
+    castlingRights.whiteRookQSidesMoved = !(pos.castling & CASTLE_WHITE_Q);
+    castlingRights.blackRookKSidesMoved = !(pos.castling & CASTLE_BLACK_K);
+    castlingRights.blackRookQSidesMoved = !(pos.castling & CASTLE_BLACK_Q);
+    clearBoard();
+
+    for (int sq = 0; sq < 64; sq++)
+    {
+        if (pos.board[sq] != NO_PIECE)
+            putPiece(pos.board[sq], sq);
+    }
+    setSideToMove(pos.sideToMove == WHITE);
+
+    // 50手ルールの手数より前の局面は無いので、千日手の判定はこの局面から始まる
+    rule50_ = pos.rule50;
+    gamePly_ = 2 * (pos.fullmove - 1) + (pos.sideToMove == WHITE ? 0 : 1);
+    epSquare_ = pos.epSquare;
+}
+
+void ChessGame::getPosition(FenPosition &pos) const
+{
+    for (int sq = 0; sq < 64; sq++)
+        pos.board[sq] = mailbox_[sq];
+    pos.sideToMove = sideToMove_;
+    pos.castling = castlingIndexOnBoard();
+    pos.epSquare = epSquare_;
+    pos.rule50 = rule50_;
+    pos.fullmove = gamePly_ / 2 + 1;
 }
 
 // -------------------------------------------------------------
@@ -1240,19 +2356,25 @@ std::string ChessGame::moveToAlgebratic(Move move) const
     return start_alg + end_alg;
 }
 
+std::string ChessGame::moveToAlgebratic(PackedMove move) const
+{
+    std::string alg = moveToAlgebratic(move.toMove());
+    if (move.kind() == MOVE_PROMOTION)
+        alg += (char)std::tolower(pieceToChar(makePiece(WHITE, move.promotion())));
+    return alg;
+}
+
 bool ChessGame::isLegal(Move move, bool turnWhite) const
 {
-    std::vector<Move> moves = generateMoves(turnWhite);
-    auto it = std::find(moves.begin(), moves.end(), move);
+    MoveList moves;
+    generateLegalMoves(turnWhite, GEN_ALL, moves);
 
-    if (it != moves.end())
-    {
-        return true;
-    }
-    else
+    for (PackedMove m : moves)
     {
-        return false;
+        if (m.toMove() == move)
+            return true;
     }
+    return false;
 }
 
 bool ChessGame::algebraicToMove(const std::string &moveString, Move &move)
@@ -1291,6 +2413,48 @@ bool ChessGame::algebraicToMove(const std::string &moveString, Move &move)
     return true;
 }
 
+/**
+ * 'e2e4' / 'e7e8q' のような文字列を、手番側の合法手 (探索用の16bitの指し手) に変換する
+ * 合法手に無ければ false を返す
+ */
+bool ChessGame::algebraicToMove(const std::string &moveString, PackedMove &move) const
+{
+    if (moveString.length() != 4 && moveString.length() != 5)
+    {
+        return false;
+    }
+
+    int startRow, startCol, endRow, endCol;
+    if (!algebraicToCoords(moveString.substr(0, 2), startRow, startCol) ||
+        !algebraicToCoords(moveString.substr(2, 2), endRow, endCol))
+    {
+        return false;
+    }
+
+    // 昇格する駒 (省略時はクイーン)
+    int promotion = QUEEN;
+    if (moveString.length() == 5)
+    {
+        int piece = charToPiece(std::toupper(moveString[4]));
+        if (piece == NO_PIECE || typeOf(piece) == PAWN || typeOf(piece) == KING)
+            return false;
+        promotion = typeOf(piece);
+    }
+
+    MoveList moves;
+    generateLegalMoves(sideToMove_ == WHITE, GEN_ALL, moves);
+    int from = makeSquare(startRow, startCol), to = makeSquare(endRow, endCol);
+    for (PackedMove m : moves)
+    {
+        if (m.from() == from && m.to() == to && (m.kind() != MOVE_PROMOTION || m.promotion() == promotion))
+        {
+            move = m;
+            return true;
+        }
+    }
+    return false;
+}
+
 void ChessGame::getBoardAsStrings(std::string (&rows)[8]) const
 {
     for (int i = 0; i < 8; i++) // 行 (0から7)
@@ -1301,8 +2465,8 @@ void ChessGame::getBoardAsStrings(std::string (&rows)[8]) const
 
         for (int j = 0; j < 8; j++) // 列 (0から7)
         {
-            // Piece構造体から駒の種類を示す文字を取得し、追加
-            char c = board[i][j].type;
+            // 駒コードから駒の種類を示す文字を取得し、追加
+            char c = pieceToChar(mailbox_[makeSquare(i, j)]);
             rows[i].push_back(c);
         }
     }
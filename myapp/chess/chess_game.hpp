@@ -20,8 +20,25 @@
 #include <ctime>
 #include <cctype>
 #include <algorithm>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string_view>
 
 #include "types.hpp"
+#include "bitboard.hpp"
+#include "bitbase.hpp"
+#include "fen.hpp"
+#include "move.hpp"
+#include "zobrist.hpp"
+#include "transposition_table.hpp"
+#include "move_picker.hpp"
+#include "pawn_table.hpp"
+#include "psqt.hpp"
+#include "perft_cache.hpp"
+#include "polyglot_book.hpp"
 
 // キャスリング判定のための移動履歴
 struct CastlingRights
@@ -34,11 +51,136 @@ struct CastlingRights
     bool blackRookKSidesMoved = false;
 };
 
+// AI探索用 Undo 情報 (makeMoveInternal で記録し unmakeMoveInternal で戻す)
+struct UndoInfo
+{
+    int captured = NO_PIECE; // 取られた駒コード (キャスリング・昇格かどうかは PackedMove に含まれる)
+    CastlingRights castlingRights; // 移動前のキャスリング権
+    int rule50 = 0;          // 移動前の rule50_
+};
+
+// 指し手生成の種類
+enum GenType
+{
+    GEN_ALL,      // 全ての合法手
+    GEN_CAPTURES, // 駒を取る手と昇格
+    GEN_QUIETS    // それ以外 (キャスリングを含む)
+};
+
+// 探索の打ち切り条件 (0 = 制限なし)
+// 全て0の場合は stopSearch() が呼ばれるまで考え続ける
+struct SearchLimits
+{
+    int depth = 0;           // 最大深さ
+    std::uint64_t nodes = 0; // 最大ノード数
+    int timeMs = 0;          // 思考時間 (ミリ秒)
+    bool ponder = false;     // 相手の手番の先読み (ponderHit() が呼ばれるまでは timeMs で止めない)
+    int multiPv = 1;         // 上位何手を求めるか (2以上なら multi-PV: 各手に評価値と最善手順を付ける)
+};
+
+// multi-PV の1行 (候補手とその評価値・最善手順)
+struct PvLine
+{
+    Move move = MOVE_NONE;
+    int score = 0;               // 評価値 (白から見た値)
+    int mateIn = 0;              // メイトまでの手数 (SearchInfo::mateIn と同じ)
+    std::vector<std::string> pv; // 最善手順 ("e2e4" 形式、先頭は move)
+};
+
+// 直前の探索の結果 (最後に完了した反復のもの)
+struct SearchStats
+{
+    int depth = 0;           // 完了した深さ
+    int score = 0;           // 評価値 (白から見た値)
+    std::uint64_t nodes = 0; // 探索したノード数 (全スレッドの合計、静止探索・途中で打ち切った反復も含む)
+    std::uint64_t qnodes = 0; // そのうち静止探索のノード数
+    std::uint64_t cutoffs = 0;          // 枝刈りが起きたノード数 (静止探索以外、メインスレッドのみ)
+    std::uint64_t firstMoveCutoffs = 0; // そのうち最初の手で枝刈りできたノード数
+    std::uint64_t pawnProbes = 0;       // ポーンのハッシュ表の参照回数 (メインスレッドのみ)
+    std::uint64_t pawnHits = 0;         // そのうちヒットした回数
+    TranspositionTable::Stats tt;       // 置換表の参照・書き込みの回数 (全スレッドの合計)
+    double timeMs = 0;       // 思考時間
+    bool bookMove = false;   // オープニングブックの手を指した (探索していない)
+    Move ponderMove = MOVE_NONE; // 予想される相手の応手 (最善手順の2手目、分からなければ MOVE_NONE)
+    std::vector<PvLine> lines;   // multi-PV の候補手 (良い順、SearchLimits::multiPv が2以上の時だけ)
+
+    // 手の並べ替えの良さの目安 (1に近いほど良い)
+    double firstMoveCutoffRate() const { return cutoffs ? double(firstMoveCutoffs) / cutoffs : 0.0; }
+    double pawnHitRate() const { return pawnProbes ? double(pawnHits) / pawnProbes : 0.0; }
+    double ttHitRate() const { return tt.probes ? double(tt.hits) / tt.probes : 0.0; }
+};
+
+// 探索中の途中経過 (反復深化の反復が1つ完了するたびにメインスレッドから通知する)
+struct SearchInfo
+{
+    int depth = 0;           // 完了した深さ
+    int multiPv = 1;         // 何番目の候補手か (multi-PV では深さごとに1番目から順に通知する)
+    int selDepth = 0;        // 静止探索も含めて到達した最大の手数
+    std::uint64_t nodes = 0; // ノード数 (全スレッドの合計、補助スレッドの分は1024ノード単位)
+    double nps = 0;          // 1秒あたりのノード数
+    int score = 0;           // 評価値 (白から見た値)
+    int mateIn = 0;          // メイトまでの手数 (正 = 白の勝ち、負 = 黒の勝ち、0 = メイトではない)
+    std::vector<std::string> pv; // 最善手順 ("e2e4" 形式、昇格は "e7e8q")
+    double ttHitRate = 0;    // 置換表のヒット率 (この探索での参照に対して、メインスレッドのみ)
+    int hashfull = 0;        // 置換表の使用率 (1000分率)
+    std::uint64_t cutoffs = 0;          // 枝刈りが起きたノード数 (メインスレッドのみ)
+    std::uint64_t firstMoveCutoffs = 0; // そのうち最初の手で枝刈りできたノード数
+    double timeMs = 0;       // 探索開始からの経過時間
+
+    // 1行のJSONにする (ログファイル用)
+    std::string toJson() const;
+};
+
+using SearchInfoCallback = std::function<void(const SearchInfo &)>;
+
+// 非同期探索の通知先 (どちらも探索スレッドから呼ばれる)
+struct SearchCallbacks
+{
+    SearchInfoCallback onInfo;                                      // 反復ごとの途中経過
+    std::function<void(const Move &, const SearchStats &)> onDone; // 探索の終了 (止めた場合も呼ばれる)
+};
+
+class ChessGame;
+struct InfoLog; // 途中経過の JSON lines の出力先 (chess_game.cpp)
+
+// 非同期探索のハンドル (ChessGame::startSearch が返す)
+// 破棄すると探索を止め、終わるまで待つ
+class SearchHandle
+{
+public:
+    SearchHandle();
+    SearchHandle(SearchHandle &&other) noexcept;
+    SearchHandle &operator=(SearchHandle &&other) noexcept;
+    ~SearchHandle();
+
+    // 探索を止める (数ミリ秒以内に、その時点の最善手で終わる)
+    void stop();
+    // 先読み (SearchLimits::ponder) から通常の探索に切り替える (ChessGame::ponderHit と同じ)
+    void ponderHit();
+    // 探索が終わるまで待つ
+    void wait();
+    // 探索が終わったか (待たない)
+    bool ready() const;
+    bool valid() const { return state_ != nullptr; }
+
+    // 結果 (終わっていなければ待つ)
+    Move get();
+    const SearchStats &stats();
+
+private:
+    friend class ChessGame;
+    struct State;
+    std::unique_ptr<State> state_;
+};
+
 class ChessGame
 {
+    friend class MovePicker;
+
 public:
     // コンストラクタ: 盤面初期化
-    ChessGame();
+    // hashSizeMB: 置換表のサイズ (MB)。コピーしたオブジェクトとは置換表を共有する
+    explicit ChessGame(std::size_t hashSizeMB = 16);
 
     // メインループの処理
     void initBoard();
@@ -55,11 +197,80 @@ public:
     std::vector<Move> generateMoves(bool white) const;
 
     // AI機能
-    Move bestMove(bool white);
+    // 反復深化で深さ1から順に探索し、最後に完了した反復の最善手を返す
+    Move bestMove(bool white); // setSearchLimits() の条件で探索
+    Move bestMove(bool white, const SearchLimits &limits);
+
+    // 既定の打ち切り条件 (初期値は1手1秒)
+    void setSearchLimits(const SearchLimits &limits) { searchLimits_ = limits; }
+    const SearchLimits &searchLimits() const { return searchLimits_; }
+
+    // 探索スレッド数 (Lazy SMP: 2以上なら補助スレッドが同じ局面を並列に読み、置換表を共有する)
+    void setThreads(int threads) { threads_ = std::max(1, threads); }
+    int threads() const { return threads_; }
+
+    // 探索を止める (別スレッドから呼んでもよい)
+    // bestMove() はその時点で完了している反復の最善手を返す
+    void stopSearch() { stop_->store(true); }
+
+    // 相手が予想どおりに指したので、先読み (SearchLimits::ponder) を通常の探索に切り替える (別スレッドから呼んでもよい)
+    // 思考時間は先読みを始めた時から数えるので、先読みで使い切っていればすぐに止まる
+    void ponderHit() { ponder_->store(false); }
+
+    // 探索を別スレッドで始める (GUIを止めないための非同期版)
+    // 盤面はコピーして探索するので、探索中もこのオブジェクトの盤面を変更してよい
+    // 置換表だけは共有するので、探索中にサイズを変えないこと
+    SearchHandle startSearch(bool white, const SearchLimits &limits, SearchCallbacks callbacks = SearchCallbacks()) const;
+
+    const SearchStats &lastSearch() const { return lastSearch_; }
+
+    // 途中経過の通知先 (空の関数を渡すと通知しない)
+    // コールバックは探索しているスレッドから呼ばれる
+    void setInfoCallback(SearchInfoCallback callback) { infoCallback_ = std::move(callback); }
+
+    // 途中経過を JSON lines でファイルに追記する (空文字列で止める)
+    bool setInfoLog(const std::string &path);
+
+    // オープニングブック (Polyglot 形式)
+    // ブックにある局面では探索せずにブックの手を返す。ブックはコピーしたオブジェクトと共有する
+    // openBook は開けなければ false を返し、ブックを外す (空の path で外すのにも使う)
+    bool openBook(const std::string &path, const BookOptions &options = BookOptions());
+    void setBook(std::shared_ptr<const PolyglotBook> book, const BookOptions &options = BookOptions());
+    void setBookOptions(const BookOptions &options) { bookOptions_ = options; }
+    const BookOptions &bookOptions() const { return bookOptions_; }
+    const PolyglotBook *book() const { return book_.get(); }
+
+    // 現局面の Polyglot キー (ブックの乱数表で計算する、ブックが無ければ0)
+    Key bookKey() const;
+    // 手番側のブックの手 (無い・手数の上限を超えた場合は PACKED_MOVE_NONE)
+    PackedMove probeBook() const;
+
+    // 開始局面からの手数 (setFen の手数から数える、initBoardWithStrings では0から)
+    int gamePly() const { return gamePly_; }
+
+    // 3駒の終盤 (KPK, KRK, KQK) のビットベース (chess-tools の bitbase_gen で作る)
+    // dir の kpk.bb などを開き、開けたファイル数を返す。コピーしたオブジェクトと共有する
+    int loadBitbases(const std::string &dir);
+    const Bitbases *bitbases() const { return bitbases_.get(); }
+    // 現局面の結果 (手番側から見た値、ビットベースの無い局面は BITBASE_UNKNOWN)
+    BitbaseResult probeBitbase() const;
 
     // FENから盤面設定
     void initBoardWithStrings(const std::string rows[8]);
 
+    // FEN文字列から盤面・手番・キャスリング権・アンパサンのマス・手数を設定する (fen.hpp の parseFen で読む)
+    // 書式が正しくなければ false を返し、盤面は変えない
+    bool setFen(std::string_view fen);
+    // 現局面を FEN にして buffer に書く (ヒープは使わない、返す文字列は buffer を指す)
+    std::string_view fen(FenBuffer &buffer) const;
+
+    // FEN の6つのフィールドとの間で局面を受け渡す
+    // (キャスリング権はキングとルークが元のマスにある場合だけ数える)
+    void setPosition(const FenPosition &pos);
+    void getPosition(FenPosition &pos) const;
+
+    bool sideToMoveIsWhite() const { return sideToMove_ == WHITE; }
+
     // FENから最善手
     Move getBestMoveFromBoard(const std::string rows[8], bool turnWhite);
 
@@ -69,40 +280,179 @@ public:
     // 座標から代数表記に変換する (GUI表示用)
     std::string coordsToAlgebraic(int r, int c) const;
     std::string moveToAlgebratic(Move move) const;
+    std::string moveToAlgebratic(PackedMove move) const; // 昇格する駒を付ける ("e7e8q")
 
     bool isLegal(Move move, bool turnWhite) const;
 
     bool algebraicToMove(const std::string &moveString, Move &move);
+    // 手番側の合法手に変換する ("e7e8q" のように昇格する駒を付けてもよい)
+    bool algebraicToMove(const std::string &moveString, PackedMove &move) const;
+
+    // 座標のペア -> 探索用の16bitの指し手 (盤面から昇格・キャスリングを判定する)
+    PackedMove toPackedMove(const Move &m) const;
 
     void getBoardAsStrings(std::string (&rows)[8]) const;
 
     bool isEnd(bool turnWhite);
 
+    // 静的評価 (白から見た値、検証・ベンチマーク用)
+    // staticEvaluation は差分更新版、staticEvaluationFullScan は盤面を毎回走査する従来版
+    int staticEvaluation() const { return evaluate(); }
+    int staticEvaluationFullScan() const { return evaluateFullScan(); }
+
+    // 駒の取り合いの損得 (手番側から見た値、検証用)
+    int staticExchange(PackedMove move) const { return see(move); }
+    bool staticExchangeGe(PackedMove move, int threshold) const { return seeGe(move, threshold); }
+
+    // 深さ depth までの合法手の木の末端ノード数 (指し手生成の検証・速度計測用)
+    // cache を渡すと、合流した局面を数え直さない
+    std::uint64_t perft(bool white, int depth, PerftCache *cache = nullptr);
+
+    // 置換表 (サイズ変更用、統計は lastSearch().tt)
+    TranspositionTable &transpositionTable() { return *tt_; }
+
+    // ポーン構造のハッシュ表 (サイズ・ヒット率の確認用)
+    const PawnHashTable &pawnTable() const { return *pawnTable_; }
+
 private:
     // 状態をカプセル化 (グローバル変数の廃止)
-    Piece board[8][8];
+    // 盤面はビットボードで保持し、マス->駒の逆引き用に mailbox_ を併用する
+    Bitboard pieceBB_[2][6] = {}; // [色][駒種] ごとの集合
+    Bitboard colorBB_[2] = {};    // 色ごとの占有マス
+    Bitboard occupiedBB_ = 0;     // 全占有マス
+    int mailbox_[64];             // マス -> 駒コード (NO_PIECE = 空マス)
     CastlingRights castlingRights;
-    const int MAX_DEPTH = 4; // Minimaxの深さ
 
-    std::vector<std::string> position_history_; // perprtual check判定用盤面履歴
+    int sideToMove_ = WHITE;     // 手番 (makeMoveInternal で交代)
+    Key key_ = 0;                // 現局面のZobristキー (差分更新)
+    int rule50_ = 0;             // 最後の駒取り/ポーン移動からの手数
+    std::vector<Key> keyHistory_; // perpetual check判定用のキー履歴 (探索中の局面も含む)
+    Score psqScore_ = 0;         // 駒の価値 + 位置的価値 (序中盤と終盤の値の組、白から見た値、差分更新)
+    int phase_ = 0;              // ポーン以外の駒の量 (PhaseWeight の合計、差分更新)
+    Key pawnKey_ = 0;            // ポーンだけのZobristキー (差分更新)
+    int gamePly_ = 0;            // 開始局面からの手数 (makeMove で数える、探索中の手は含まない)
+    int epSquare_ = NO_SQUARE;   // 直前の2マス前進でポーンが通過したマス (FEN・ブックのキー用、makeMove で更新する)
+
+    std::shared_ptr<TranspositionTable> tt_; // 置換表
+
+    static constexpr std::size_t PAWN_HASH_SIZE_KB = 512;
+    std::shared_ptr<PawnHashTable> pawnTable_; // ポーン構造のハッシュ表 (並列探索の補助スレッドは別の表を持つ)
+
+    // 探索の制御
+    // 並列探索では、盤面ごとこのオブジェクトをコピーしたものを補助スレッドごとの探索状態にする
+    // (置換表と停止フラグはコピー間で共有される)
+    SearchLimits searchLimits_;                 // bestMove(bool) で使う打ち切り条件
+    int threads_ = 1;                           // 探索スレッド数
+    SearchLimits limits_;                       // 探索中の打ち切り条件
+    std::vector<PackedMove> lineMoves_;         // multi-PV: 最後に完了した反復の候補手 (良い順)
+    std::vector<int> lineScores_;               // その評価値 (手番側から見た値)
+    std::shared_ptr<std::atomic<bool>> stop_;   // 停止フラグ
+    std::shared_ptr<std::atomic<bool>> ponder_; // 先読み中 (思考時間で止めない)
+    std::uint64_t nodes_ = 0;                   // 探索中のノード数
+    std::uint64_t qnodes_ = 0;                  // そのうち静止探索のノード数
+    std::uint64_t cutoffs_ = 0;
+    std::uint64_t firstMoveCutoffs_ = 0;
+    TranspositionTable::Stats ttStats_;         // このスレッドの置換表の参照・書き込みの回数
+    int selDepth_ = 0;                          // 到達した最大の手数
+    std::shared_ptr<std::atomic<std::uint64_t>> sharedNodes_; // 全スレッドのノード数 (1024ノードごとに加算)
+    std::chrono::steady_clock::time_point startTime_;
+    SearchStats lastSearch_;
+
+    // 途中経過の通知
+    SearchInfoCallback infoCallback_;
+    std::shared_ptr<InfoLog> infoLog_;          // JSON lines の出力先 (コピー間で共有、書き込みは排他)
+
+    // オープニングブック
+    std::shared_ptr<const PolyglotBook> book_;
+    BookOptions bookOptions_;
+    std::shared_ptr<std::atomic<int>> bookTimeBank_; // ブックの手で使わなかった思考時間 (ミリ秒、コピー間で共有)
+
+    // 終盤のビットベース
+    static constexpr int BITBASE_WIN_SCORE = 100000; // 勝ちと分かっている局面の評価値 (メイトのスコアよりは小さい)
+    std::shared_ptr<const Bitbases> bitbases_;
+    bool rootInBitbase_ = false; // ルート局面が既にビットベースの終盤か (それなら探索で勝ち方を読む)
+
+    // 手の並べ替え用
+    PackedMove killers_[MAX_PLY + 1][2];  // 深さごとに枝刈りを起こした取らない手 (2つまで)
+    int history_[2][64][64] = {};   // [色][移動元][移動先] 枝刈りを起こした取らない手の実績
 
     // ヘルパー関数
+    void clearBoard();
+    void putPiece(int piece, int sq);
+    void removePiece(int sq);
+    void movePiece(int from, int to);
     bool algebraicToCoords(const std::string &alg, int &row, int &col) const;
     void updateCastlingRights(int r1, int c1);
     std::pair<int, int> findKing(bool white) const;
     bool isKingOnBoard(bool white) const;
     bool isSquareAttacked(int r, int c, bool attackingWhite) const;
-    void generateSlidingMoves(int r, int c, bool white, char type, std::vector<Move> &moves) const;
+    Bitboard attackersTo(int sq, Bitboard occupied) const;
+    Bitboard pinnedPieces(int color, int ksq) const;
+    void generateSlidingMoves(int sq, int type, Bitboard allowed, MoveList &moves) const;
+    void generateCastlingMoves(int us, int ksq, MoveList &moves) const;
+    void addMoves(int from, Bitboard targets, MoveList &moves) const;
+    void generateLegalMoves(bool white, GenType type, MoveList &moves, Bitboard fromMask = ~Bitboard(0)) const;
+    bool isMoveLegal(bool white, PackedMove m) const;
+    bool isQuietMove(PackedMove m) const;
 
-    std::string getBoardStateFEN(bool turnWhite) const;
+    int castlingIndex() const;
+    int castlingIndexOnBoard() const; // キングとルークが元のマスにあるものだけ残す (Polyglot・FEN 用)
+    void setSideToMove(bool white);
 
+    int repetitionCount() const;
     bool isDrawByThreefoldRepetition(bool turnWhite) const;
 
     // AI探索専用の移動 (CastlingRightsは更新しない)
-    void makeMoveInternal(Move m, Piece &capturedPiece);
-    void unmakeMoveInternal(Move m, Piece capturedPiece);
+    void makeMoveInternal(PackedMove m, UndoInfo &undo);
+    void unmakeMoveInternal(PackedMove m, const UndoInfo &undo);
+
+    std::uint64_t perftInternal(int depth, PerftCache *cache);
+
+    PackedMove pickBookMove(const MoveList &legalMoves) const;
 
-    // Minimax
+    // 探索 (Negamax + PVS)
+    static constexpr int NULL_MOVE_MIN_DEPTH = 3; // ヌルムーブ枝刈りを行う最小の深さ
+    static constexpr int LMR_MIN_DEPTH = 3;       // Late Move Reductions を行う最小の深さ
+    static constexpr int LMR_MIN_MOVES = 3;       // 最初のこの手数は減らさない
     int evaluate() const;
-    int minimax(int depth, bool isMaximizingPlayer, int alpha, int beta);
+    int evaluateFullScan() const;
+    bool evaluateBitbase(int &score) const;
+    int gamePhase() const;
+    int passedPawnScore(Bitboard passed[2]) const;
+    const PawnEntry &pawnEntry() const;
+    Bitboard attackedBy(int color) const;
+    int negamax(int depth, int ply, int alpha, int beta, bool allowNull);
+    bool inCheck() const;
+    bool hasNonPawnMaterial(int color) const;
+    void makeNullMove(UndoInfo &undo);
+    void unmakeNullMove(const UndoInfo &undo);
+
+    // 静止探索
+    static constexpr int QS_DELTA_MARGIN = 200; // Delta pruning の余裕 (ポーン1枚分)
+    int quiescence(int ply, int alpha, int beta);
+    int captureGain(PackedMove m) const;
+
+    // 静的交換評価 (SEE): 移動先のマスで安い駒から順に取り合った結果の損得
+    static constexpr int SEE_PRUNE_DEPTH = 3;       // この深さ以下で損な駒取りを読まない
+    static constexpr int SEE_CAPTURE_MARGIN = 100;  // 深さ1あたりに許す損 (ポーン半分)
+    int see(PackedMove m) const;
+    bool seeGe(PackedMove m, int threshold) const; // see(m) >= threshold (値が決まった時点で打ち切る)
+
+    // 手の並べ替え (キラー手・ヒストリー)
+    static constexpr int HISTORY_MAX = 1 << 20;
+    void updateQuietHeuristics(PackedMove m, int ply, int depth);
+
+    // 反復深化
+    static constexpr int ASPIRATION_MIN_DEPTH = 4; // この深さから前回の値の近くに窓を絞る
+    static constexpr int ASPIRATION_WINDOW = 50;   // 最初の窓の幅 (外れるたびに2倍)
+    static constexpr int ASPIRATION_MAX = 1000;    // これより広がったら全幅に戻す
+    int iterativeDeepening(MoveList &moves, int maxDepth, int threadId, int &bestScore);
+    bool searchRoot(int depth, int alpha, int beta, MoveList &moves, std::size_t first, int &bestScore);
+    void collectTiedMoves(int depth, int bestScore, const MoveList &moves, MoveList &tiedMoves);
+    bool checkStop();
+    double elapsedMs() const;
+    void extractPv(PackedMove first, int maxLength, std::vector<PackedMove> &pv);
+    PvLine makePvLine(PackedMove move, int score, int depth);
+    void reportInfo(int depth, int score, PackedMove best, int multiPv);
+    Move search(bool white, const SearchLimits &limits);
 };
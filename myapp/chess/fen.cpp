@@ -0,0 +1,268 @@
+#include "fen.hpp"
+
+// -------------------------------------------------------------
+// 文字 <-> 駒コード (charToPiece は12文字を順に比べるので、読み込み用に表を引く)
+// -------------------------------------------------------------
+
+static constexpr char PIECE_CHARS[] = "PNBRQKpnbrqk";
+
+struct PieceCharTable
+{
+    unsigned char piece[256];
+};
+
+static constexpr PieceCharTable makePieceCharTable()
+{
+    PieceCharTable table{};
+    for (int c = 0; c < 256; c++)
+        table.piece[c] = NO_PIECE;
+    for (int piece = 0; piece < NO_PIECE; piece++)
+        table.piece[(unsigned char)PIECE_CHARS[piece]] = (unsigned char)piece;
+    return table;
+}
+
+static constexpr PieceCharTable PIECE_OF_CHAR = makePieceCharTable();
+
+// -------------------------------------------------------------
+// 読み込み
+// -------------------------------------------------------------
+
+// 手数として読む最大の桁数 (int があふれない範囲)
+static constexpr std::size_t MAX_NUMBER_DIGITS = 9;
+
+static bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// pos から次のフィールド (空白の前まで) を取り出す。フィールドが残っていなければ空を返す
+static std::string_view nextField(std::string_view fen, std::size_t &pos)
+{
+    while (pos < fen.size() && isSpace(fen[pos]))
+        pos++;
+    std::size_t start = pos;
+    while (pos < fen.size() && !isSpace(fen[pos]))
+        pos++;
+    return fen.substr(start, pos - start);
+}
+
+// 8段目から '/' 区切り、数字は空マスの数
+// マス番号は8段目の a ファイルから順に並ぶので、読んだ順に board に入れればよい
+static bool parseBoard(std::string_view field, int board[64])
+{
+    int sq = 0;
+    int col = 0; // 今の段で埋めたマス数
+    for (char c : field)
+    {
+        if (c == '/')
+        {
+            if (col != 8 || sq == 64)
+                return false;
+            col = 0;
+        }
+        else if (c >= '1' && c <= '8')
+        {
+            int count = c - '0';
+            if (col + count > 8)
+                return false;
+            for (int i = 0; i < count; i++)
+                board[sq++] = NO_PIECE;
+            col += count;
+        }
+        else
+        {
+            int piece = PIECE_OF_CHAR.piece[(unsigned char)c];
+            if (piece == NO_PIECE || col == 8)
+                return false;
+            board[sq++] = piece;
+            col++;
+        }
+    }
+    return sq == 64 && col == 8;
+}
+
+// "-" または "KQkq" の部分列 (順序は問わない、同じ文字の重複は不可)
+static bool parseCastling(std::string_view field, int &castling)
+{
+    castling = 0;
+    if (field == "-")
+        return true;
+    if (field.empty() || field.size() > 4)
+        return false;
+    for (char c : field)
+    {
+        int bit;
+        switch (c)
+        {
+        case 'K': bit = CASTLE_WHITE_K; break;
+        case 'Q': bit = CASTLE_WHITE_Q; break;
+        case 'k': bit = CASTLE_BLACK_K; break;
+        case 'q': bit = CASTLE_BLACK_Q; break;
+        default: return false;
+        }
+        if (castling & bit)
+            return false;
+        castling |= bit;
+    }
+    return true;
+}
+
+// "-" または "e3" のようなマス (白番なら6段目、黒番なら3段目)
+static bool parseEnPassant(std::string_view field, int sideToMove, int &epSquare)
+{
+    epSquare = NO_SQUARE;
+    if (field == "-")
+        return true;
+    if (field.size() != 2 || field[0] < 'a' || field[0] > 'h')
+        return false;
+    if (field[1] != (sideToMove == WHITE ? '6' : '3'))
+        return false;
+    epSquare = makeSquare('8' - field[1], field[0] - 'a');
+    return true;
+}
+
+static bool parseNumber(std::string_view field, int &value)
+{
+    if (field.empty() || field.size() > MAX_NUMBER_DIGITS)
+        return false;
+    value = 0;
+    for (char c : field)
+    {
+        if (c < '0' || c > '9')
+            return false;
+        value = value * 10 + (c - '0');
+    }
+    return true;
+}
+
+bool parseFen(std::string_view fen, FenPosition &pos)
+{
+    std::size_t cursor = 0;
+    if (!parseBoard(nextField(fen, cursor), pos.board))
+        return false;
+
+    // 省略されたフィールドは "w - - 0 1"
+    pos.sideToMove = WHITE;
+    pos.castling = 0;
+    pos.epSquare = NO_SQUARE;
+    pos.rule50 = 0;
+    pos.fullmove = 1;
+
+    std::string_view field = nextField(fen, cursor);
+    if (field.empty())
+        return true;
+    if (field == "w")
+        pos.sideToMove = WHITE;
+    else if (field == "b")
+        pos.sideToMove = BLACK;
+    else
+        return false;
+
+    field = nextField(fen, cursor);
+    if (field.empty())
+        return true;
+    if (!parseCastling(field, pos.castling))
+        return false;
+
+    field = nextField(fen, cursor);
+    if (field.empty())
+        return true;
+    if (!parseEnPassant(field, pos.sideToMove, pos.epSquare))
+        return false;
+
+    field = nextField(fen, cursor);
+    if (field.empty())
+        return true;
+    if (!parseNumber(field, pos.rule50))
+        return false;
+
+    field = nextField(fen, cursor);
+    if (field.empty())
+        return true;
+    if (!parseNumber(field, pos.fullmove))
+        return false;
+    if (pos.fullmove == 0) // "0 0" と書くプログラムもあるので1手目とみなす
+        pos.fullmove = 1;
+
+    // 後ろに余計なものがあれば FEN ではない
+    return nextField(fen, cursor).empty();
+}
+
+// -------------------------------------------------------------
+// 書き出し
+// -------------------------------------------------------------
+
+static char *writeNumber(char *out, int value)
+{
+    char digits[12];
+    int count = 0;
+    unsigned int v = value < 0 ? 0u : (unsigned int)value;
+    do
+    {
+        digits[count++] = char('0' + v % 10);
+        v /= 10;
+    } while (v);
+    while (count > 0)
+        *out++ = digits[--count];
+    return out;
+}
+
+std::string_view writeFen(const FenPosition &pos, FenBuffer &buffer)
+{
+    char *out = buffer.data;
+
+    for (int row = 0; row < 8; row++)
+    {
+        if (row > 0)
+            *out++ = '/';
+        int empty = 0;
+        for (int col = 0; col < 8; col++)
+        {
+            int piece = pos.board[makeSquare(row, col)];
+            if (piece == NO_PIECE)
+            {
+                empty++;
+                continue;
+            }
+            if (empty)
+                *out++ = char('0' + empty);
+            empty = 0;
+            *out++ = PIECE_CHARS[piece];
+        }
+        if (empty)
+            *out++ = char('0' + empty);
+    }
+
+    *out++ = ' ';
+    *out++ = (pos.sideToMove == WHITE) ? 'w' : 'b';
+
+    *out++ = ' ';
+    if (pos.castling == 0)
+        *out++ = '-';
+    if (pos.castling & CASTLE_WHITE_K)
+        *out++ = 'K';
+    if (pos.castling & CASTLE_WHITE_Q)
+        *out++ = 'Q';
+    if (pos.castling & CASTLE_BLACK_K)
+        *out++ = 'k';
+    if (pos.castling & CASTLE_BLACK_Q)
+        *out++ = 'q';
+
+    *out++ = ' ';
+    if (pos.epSquare == NO_SQUARE)
+        *out++ = '-';
+    else
+    {
+        *out++ = char('a' + colOf(pos.epSquare));
+        *out++ = char('8' - rowOf(pos.epSquare));
+    }
+
+    *out++ = ' ';
+    out = writeNumber(out, pos.rule50);
+    *out++ = ' ';
+    out = writeNumber(out, pos.fullmove);
+
+    *out = '\0';
+    buffer.length = std::size_t(out - buffer.data);
+    return buffer.view();
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+//+++
+// FEN (Forsyth-Edwards Notation) の読み書き
+// ・6つのフィールド (駒の配置・手番・キャスリング権・アンパサンのマス・50手ルールの手数・手数) を全て扱う
+//   読んだ FEN を書き出すと元と同じ文字列になる (空白の数などの書き方の違いを除く)
+// ・読み込みは std::string_view を先頭から1回走査するだけ、書き出しは固定長の FenBuffer に書くだけで、
+//   どちらもヒープを使わない (GUI・UCI・ツールから1局面1マイクロ秒程度で読み書きできる)
+// ・手番より後ろのフィールドは省略してもよい (盤面だけの文字列も読めるように、省略時は "w - - 0 1")
+//+++
+
+#include <cstddef>
+#include <string_view>
+
+#include "bitboard.hpp"
+
+// キャスリング権 (ChessGame::castlingIndex と同じ4bit)
+enum CastlingBits
+{
+    CASTLE_WHITE_K = 1,
+    CASTLE_WHITE_Q = 2,
+    CASTLE_BLACK_K = 4,
+    CASTLE_BLACK_Q = 8
+};
+
+// FEN の6つのフィールドをそのまま持つ局面
+struct FenPosition
+{
+    int board[64];               // マス (makeSquare の番号、[0] が a8) -> 駒コード (NO_PIECE = 空マス)
+    int sideToMove = WHITE;
+    int castling = 0;            // CastlingBits の組み合わせ
+    int epSquare = NO_SQUARE;    // 直前の2マス前進でポーンが通過したマス
+    int rule50 = 0;              // 最後の駒取り/ポーン移動からの手数 (片方の手で数える)
+    int fullmove = 1;            // 手数 (黒が指すと1増える)
+};
+
+// 書き出し先 (盤面は最大71文字、手番・キャスリング権・アンパサンで11文字、手数は int の10桁 x 2)
+struct FenBuffer
+{
+    static constexpr std::size_t CAPACITY = 128;
+
+    char data[CAPACITY];
+    std::size_t length = 0;
+
+    std::string_view view() const { return std::string_view(data, length); }
+    const char *c_str() const { return data; } // data[length] は '\0'
+};
+
+// fen を読む。書式が正しくなければ false を返す (pos は不定)
+// 盤面の8段 x 8マス・手番・キャスリング権の文字・アンパサンのマスの段 (手番と合うこと)・手数が数であることを確かめる
+// (キングの数など、局面として指せるかどうかは確かめない)
+bool parseFen(std::string_view fen, FenPosition &pos);
+
+// pos を FEN にして buffer に書き、書いた文字列を返す
+std::string_view writeFen(const FenPosition &pos, FenBuffer &buffer);
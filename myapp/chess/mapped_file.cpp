@@ -0,0 +1,70 @@
+#include "mapped_file.hpp"
+
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool MappedFile::open(const std::string &path, Access access)
+{
+    close();
+
+#ifdef _WIN32
+    (void)access;
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in)
+        return false;
+    std::size_t size = std::size_t(in.tellg());
+    if (size == 0)
+        return false;
+    unsigned char *buffer = new unsigned char[size];
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char *>(buffer), size))
+    {
+        delete[] buffer;
+        return false;
+    }
+    data_ = buffer;
+    mapped_ = false;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    std::size_t size = std::size_t(st.st_size);
+    void *p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // マップはファイルを閉じても残る
+    if (p == MAP_FAILED)
+        return false;
+    if (access == ACCESS_RANDOM)
+        madvise(p, size, MADV_RANDOM);
+    data_ = static_cast<const unsigned char *>(p);
+    mapped_ = true;
+#endif
+
+    size_ = size;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (!data_)
+        return;
+#ifndef _WIN32
+    if (mapped_)
+        munmap(const_cast<unsigned char *>(data_), size_);
+    else
+#endif
+        delete[] data_;
+    data_ = nullptr;
+    size_ = 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+//+++
+// 読み込み専用のメモリマップしたファイル (オープニングブック・ビットベース用)
+// ・開く時にファイル全体を読み込まず、参照したページだけがOSによって読まれる
+// ・同じファイルを複数のプロセスで開いても物理メモリは共有される
+// ・メモリマップが使えない環境 (Windows) ではヒープに読み込む
+//+++
+
+#include <cstddef>
+#include <string>
+
+class MappedFile
+{
+public:
+    // ランダムに読む (二分探索など) なら先読みさせない
+    enum Access
+    {
+        ACCESS_SEQUENTIAL,
+        ACCESS_RANDOM
+    };
+
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // 開けない・空のファイルなら false を返す (開いていたものは閉じる)
+    bool open(const std::string &path, Access access = ACCESS_SEQUENTIAL);
+    void close();
+
+    bool isOpen() const { return data_ != nullptr; }
+    const unsigned char *data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    const unsigned char *data_ = nullptr;
+    std::size_t size_ = 0;
+    bool mapped_ = false; // false ならヒープに読み込んだ
+};
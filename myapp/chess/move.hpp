@@ -0,0 +1,96 @@
+#pragma once
+
+//+++
+// 探索用の16bitの指し手 (PackedMove) と固定長の指し手リスト (MoveList)
+// ・bit  0- 5 : 移動元のマス
+//   bit  6-11 : 移動先のマス (キャスリングはキングの移動先)
+//   bit 12-13 : 昇格する駒 (0 = ナイト 〜 3 = クイーン)
+//   bit 14-15 : 手の種類 (通常/昇格/アンパサン/キャスリング)
+// ・0 (移動元 == 移動先) は「手が無い」ことを表す
+// ・GUI と経路生成は従来どおり Move (座標のペア) を使い、toMove() や
+//   ChessGame::toPackedMove() で相互に変換する
+//+++
+
+#include <cstddef>
+#include <cstdint>
+
+#include "bitboard.hpp"
+#include "types.hpp"
+
+enum MoveKind : std::uint16_t
+{
+    MOVE_NORMAL = 0,
+    MOVE_PROMOTION = 1 << 14,
+    MOVE_EN_PASSANT = 2 << 14, // 符号化のために予約 (このプログラムはアンパサンを生成しない)
+    MOVE_CASTLING = 3 << 14
+};
+
+class PackedMove
+{
+public:
+    constexpr PackedMove() = default;
+    constexpr PackedMove(int from, int to, MoveKind kind = MOVE_NORMAL, int promotion = KNIGHT)
+        : data_(std::uint16_t(from | (to << 6) | ((promotion - KNIGHT) << 12) | kind))
+    {
+    }
+
+    // 置換表などに保存した16bitから戻す
+    static constexpr PackedMove fromRaw(std::uint16_t raw)
+    {
+        PackedMove m;
+        m.data_ = raw;
+        return m;
+    }
+
+    constexpr int from() const { return data_ & 63; }
+    constexpr int to() const { return (data_ >> 6) & 63; }
+    constexpr MoveKind kind() const { return MoveKind(data_ & (3 << 14)); }
+    constexpr int promotion() const { return ((data_ >> 12) & 3) + KNIGHT; } // 昇格する駒種 (kind() == MOVE_PROMOTION の時のみ)
+    constexpr std::uint16_t raw() const { return data_; }
+    constexpr bool isNone() const { return from() == to(); }
+
+    constexpr bool operator==(PackedMove other) const { return data_ == other.data_; }
+    constexpr bool operator!=(PackedMove other) const { return data_ != other.data_; }
+
+    // GUI・経路生成用の座標のペアに変換 (昇格する駒とキャスリングのルークの移動は含まれない)
+    Move toMove() const { return {{rowOf(from()), colOf(from())}, {rowOf(to()), colOf(to())}}; }
+
+private:
+    std::uint16_t data_ = 0;
+};
+
+constexpr PackedMove PACKED_MOVE_NONE = PackedMove();
+
+// 指し手の最大数 (合法手は最大でも218手)
+constexpr int MAX_MOVES = 256;
+
+// スタックに置く固定長の指し手リスト (生成中にヒープを使わない)
+class MoveList
+{
+public:
+    void push_back(PackedMove m) { moves_[size_++] = m; }
+    void clear() { size_ = 0; }
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    PackedMove &operator[](std::size_t i) { return moves_[i]; }
+    const PackedMove &operator[](std::size_t i) const { return moves_[i]; }
+
+    PackedMove *begin() { return moves_; }
+    PackedMove *end() { return moves_ + size_; }
+    const PackedMove *begin() const { return moves_; }
+    const PackedMove *end() const { return moves_ + size_; }
+
+    bool contains(PackedMove m) const
+    {
+        for (std::size_t i = 0; i < size_; i++)
+            if (moves_[i] == m)
+                return true;
+        return false;
+    }
+
+private:
+    PackedMove moves_[MAX_MOVES];
+    std::size_t size_ = 0;
+};
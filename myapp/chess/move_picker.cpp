@@ -0,0 +1,143 @@
+#include "move_picker.hpp"
+
+#include "chess_game.hpp"
+
+// -------------------------------------------------------------
+// MovePicker
+// -------------------------------------------------------------
+
+MovePicker::MovePicker(const ChessGame &game, bool white, PackedMove ttMove, const PackedMove (&killers)[2])
+    : game_(game), white_(white), capturesOnly_(false), stage_(STAGE_TT_MOVE), ttMove_(ttMove)
+{
+    killers_[0] = killers[0];
+    killers_[1] = killers[1];
+
+    // 置換表の手は別の局面の手かもしれないので、合法手か確かめておく
+    if (!game_.isMoveLegal(white_, ttMove_))
+    {
+        ttMove_ = PACKED_MOVE_NONE;
+        stage_ = STAGE_CAPTURES_INIT;
+    }
+}
+
+MovePicker::MovePicker(const ChessGame &game, bool white, bool inCheck)
+    : game_(game), white_(white), capturesOnly_(!inCheck), stage_(STAGE_CAPTURES_INIT), ttMove_(PACKED_MOVE_NONE)
+{
+    killers_[0] = killers_[1] = PACKED_MOVE_NONE;
+}
+
+bool MovePicker::isKiller(PackedMove move) const
+{
+    return move == killers_[0] || move == killers_[1];
+}
+
+bool MovePicker::pickBest(PackedMove &move)
+{
+    while (current_ < size_)
+    {
+        std::size_t best = current_;
+        for (std::size_t i = current_ + 1; i < size_; i++)
+        {
+            if (moves_[i].score > moves_[best].score)
+                best = i;
+        }
+        std::swap(moves_[current_], moves_[best]);
+        move = moves_[current_++].move;
+
+        // 置換表の手は最初に返しているので飛ばす
+        if (move != ttMove_)
+            return true;
+    }
+    return false;
+}
+
+bool MovePicker::next(PackedMove &move)
+{
+    switch (stage_)
+    {
+    case STAGE_TT_MOVE:
+        stage_ = STAGE_CAPTURES_INIT;
+        move = ttMove_;
+        return true;
+
+    case STAGE_CAPTURES_INIT:
+    {
+        // ★ MVV-LVA: 価値の高い駒を、価値の低い駒で取る手から
+        MoveList generated;
+        game_.generateLegalMoves(white_, GEN_CAPTURES, generated);
+        size_ = 0;
+        for (PackedMove m : generated)
+        {
+            int attacker = typeOf(game_.mailbox_[m.from()]);
+            moves_[size_++] = {m, game_.captureGain(m) * 8 - attacker};
+        }
+        current_ = 0;
+        stage_ = STAGE_CAPTURES;
+    }
+        // fallthrough
+    case STAGE_CAPTURES:
+        while (pickBest(move))
+        {
+            // ★ 取り合いで損をする駒取りは、取らない手の後に回す
+            if (!capturesOnly_ && !game_.seeGe(move, 0))
+            {
+                badCaptures_[badCount_++] = move;
+                continue;
+            }
+            return true;
+        }
+        if (capturesOnly_)
+        {
+            stage_ = STAGE_END;
+            return false;
+        }
+        stage_ = STAGE_KILLERS;
+        // fallthrough
+    case STAGE_KILLERS:
+        // ★ キラー手: 同じ深さの別の局面で枝刈りを起こした取らない手
+        while (killerIndex_ < 2)
+        {
+            PackedMove killer = killers_[killerIndex_++];
+            if (killer != ttMove_ && game_.isQuietMove(killer) && game_.isMoveLegal(white_, killer))
+            {
+                move = killer;
+                return true;
+            }
+        }
+        stage_ = STAGE_QUIETS_INIT;
+        // fallthrough
+    case STAGE_QUIETS_INIT:
+    {
+        // ★ ヒストリー: これまでに枝刈りを起こした回数が多い手から
+        int us = white_ ? WHITE : BLACK;
+        MoveList generated;
+        game_.generateLegalMoves(white_, GEN_QUIETS, generated);
+        size_ = 0;
+        for (PackedMove m : generated)
+        {
+            if (isKiller(m))
+                continue;
+            moves_[size_++] = {m, game_.history_[us][m.from()][m.to()]};
+        }
+        current_ = 0;
+        stage_ = STAGE_QUIETS;
+    }
+        // fallthrough
+    case STAGE_QUIETS:
+        if (pickBest(move))
+            return true;
+        stage_ = STAGE_BAD_CAPTURES;
+        // fallthrough
+    case STAGE_BAD_CAPTURES:
+        if (badCurrent_ < badCount_)
+        {
+            move = badCaptures_[badCurrent_++];
+            return true;
+        }
+        stage_ = STAGE_END;
+        // fallthrough
+    case STAGE_END:
+        break;
+    }
+    return false;
+}
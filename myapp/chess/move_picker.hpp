@@ -0,0 +1,68 @@
+#pragma once
+
+//+++
+// 段階的な指し手生成 (Move Picker)
+// ・置換表の手 → 駒を取る手 (MVV-LVA順) → キラー手 → 取らない手 (ヒストリー順)
+//   → 取り合いで損をする駒取り の順に1手ずつ返す
+//   (損かどうかは SEE で調べる。静止探索では損な手も返し、呼び出し側で読まないことにする)
+// ・各段階の手は必要になった時点で初めて生成するので、早い段階で枝刈りされた
+//   ノードでは取らない手の生成も並べ替えもしない
+//+++
+
+#include "move.hpp"
+
+class ChessGame;
+
+class MovePicker
+{
+public:
+    // 通常探索用 (ttMove/killers が無い場合は PACKED_MOVE_NONE)
+    MovePicker(const ChessGame &game, bool white, PackedMove ttMove, const PackedMove (&killers)[2]);
+
+    // 静止探索用 (王手されていれば全ての応手、そうでなければ取る手と昇格だけ)
+    MovePicker(const ChessGame &game, bool white, bool inCheck);
+
+    // 次に調べる手を返す (もう無ければ false)
+    bool next(PackedMove &move);
+
+private:
+    enum Stage
+    {
+        STAGE_TT_MOVE,
+        STAGE_CAPTURES_INIT,
+        STAGE_CAPTURES,
+        STAGE_KILLERS,
+        STAGE_QUIETS_INIT,
+        STAGE_QUIETS,
+        STAGE_BAD_CAPTURES,
+        STAGE_END
+    };
+
+    struct ScoredMove
+    {
+        PackedMove move;
+        int score;
+    };
+
+    // 残りの中で一番点数の高い手を取り出す (全体は並べ替えない)
+    bool pickBest(PackedMove &move);
+    bool isKiller(PackedMove move) const;
+
+    const ChessGame &game_;
+    bool white_;
+    bool capturesOnly_;
+    Stage stage_;
+    PackedMove ttMove_;
+    PackedMove killers_[2];
+    int killerIndex_ = 0;
+
+    // 生成した段階の手と点数 (スタック上の固定長配列、ヒープは使わない)
+    ScoredMove moves_[MAX_MOVES];
+    std::size_t size_ = 0;
+    std::size_t current_ = 0;
+
+    // 後回しにした損な駒取り (MVV-LVA順のまま)
+    PackedMove badCaptures_[MAX_MOVES];
+    std::size_t badCount_ = 0;
+    std::size_t badCurrent_ = 0;
+};
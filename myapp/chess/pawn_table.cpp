@@ -0,0 +1,36 @@
+#include "pawn_table.hpp"
+
+// -------------------------------------------------------------
+// PawnHashTable
+// -------------------------------------------------------------
+
+PawnHashTable::PawnHashTable(std::size_t sizeKB)
+{
+    resize(sizeKB);
+}
+
+void PawnHashTable::resize(std::size_t sizeKB)
+{
+    // 指定サイズに収まる最大の2のべき乗 (キーの下位ビットで引けるように)
+    std::size_t count = 1;
+    while (count * 2 * sizeof(PawnEntry) <= sizeKB * 1024)
+        count *= 2;
+    entries_.assign(count, PawnEntry());
+    resetStats();
+}
+
+void PawnHashTable::clear()
+{
+    entries_.assign(entries_.size(), PawnEntry());
+    resetStats();
+}
+
+PawnEntry *PawnHashTable::probe(Key key, bool &hit)
+{
+    PawnEntry *entry = &entries_[key & (entries_.size() - 1)];
+    stats_.probes++;
+    hit = (entry->key == key);
+    if (hit)
+        stats_.hits++;
+    return entry;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+//+++
+// ポーン構造のハッシュ表 (Pawn Hash Table)
+// ・ポーンだけから作ったZobristキーで、ポーン構造の評価値とパスポーンの集合をキャッシュする
+// ・探索中にポーンが動く手は少ないので、ほとんどの評価はここで済む
+// ・書き込みにロックを使わないので、スレッドごとに別の表を持つこと
+//+++
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bitboard.hpp"
+#include "zobrist.hpp"
+
+struct PawnEntry
+{
+    Key key = 0;                 // ポーンのキー (ポーンが無い局面は0なので、空きエントリのままで正しい)
+    int score = 0;               // ポーン構造の評価値 (白から見た値)
+    Bitboard passed[2] = {0, 0}; // 色ごとのパスポーン
+};
+
+class PawnHashTable
+{
+public:
+    struct Stats
+    {
+        std::uint64_t probes = 0; // 参照回数
+        std::uint64_t hits = 0;   // キーが一致した回数
+    };
+
+    explicit PawnHashTable(std::size_t sizeKB);
+
+    void resize(std::size_t sizeKB);
+    void clear();
+
+    // キーに対応するエントリを返す
+    // hit が false の場合は別の局面のエントリなので、呼び出し側で計算して書き直す
+    PawnEntry *probe(Key key, bool &hit);
+
+    std::size_t sizeKB() const { return entries_.size() * sizeof(PawnEntry) / 1024; }
+    std::size_t entryCount() const { return entries_.size(); }
+    const Stats &stats() const { return stats_; }
+    void resetStats() { stats_ = Stats(); }
+    double hitRate() const { return stats_.probes ? double(stats_.hits) / stats_.probes : 0.0; }
+
+private:
+    std::vector<PawnEntry> entries_; // 2のべき乗個
+    Stats stats_;
+};
@@ -0,0 +1,40 @@
+#include "perft_cache.hpp"
+
+// -------------------------------------------------------------
+// PerftCache
+// -------------------------------------------------------------
+
+PerftCache::PerftCache(std::size_t sizeMB)
+    : sizeMB_(sizeMB)
+{
+    // 指定サイズに収まる最大の2のべき乗
+    entryCount_ = 1;
+    while (entryCount_ * 2 * sizeof(Entry) <= sizeMB * 1024 * 1024)
+        entryCount_ *= 2;
+    entries_.reset(new Entry[entryCount_]);
+}
+
+// 残り深さが違えばノード数も違うので、深さもキーに混ぜる
+Key PerftCache::entryKey(Key key, int depth)
+{
+    return key ^ (Key(depth) * 0x9E3779B97F4A7C15ULL);
+}
+
+bool PerftCache::probe(Key key, int depth, std::uint64_t &nodes) const
+{
+    Key k = entryKey(key, depth);
+    const Entry &e = entries_[k & (entryCount_ - 1)];
+    std::uint64_t n = e.nodes.load(std::memory_order_relaxed);
+    if (n == 0 || (e.keyXorNodes.load(std::memory_order_relaxed) ^ n) != k)
+        return false;
+    nodes = n;
+    return true;
+}
+
+void PerftCache::store(Key key, int depth, std::uint64_t nodes)
+{
+    Key k = entryKey(key, depth);
+    Entry &e = entries_[k & (entryCount_ - 1)];
+    e.keyXorNodes.store(k ^ nodes, std::memory_order_relaxed);
+    e.nodes.store(nodes, std::memory_order_relaxed);
+}
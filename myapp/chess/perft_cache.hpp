@@ -0,0 +1,41 @@
+#pragma once
+
+//+++
+// perft のキャッシュ
+// ・局面のZobristキー + 残り深さ -> 末端ノード数 を保存する
+// ・同じ局面に別の手順で合流したときに数え直さない (perft の計測・検証用)
+// ・複数スレッドから同時に読み書きしてよい (ロックなし)
+//   置換表と同じく、キーとデータをXORして保存し読み出し時に検証する
+//+++
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "zobrist.hpp"
+
+class PerftCache
+{
+public:
+    explicit PerftCache(std::size_t sizeMB);
+
+    bool probe(Key key, int depth, std::uint64_t &nodes) const;
+    void store(Key key, int depth, std::uint64_t nodes);
+
+    std::size_t sizeMB() const { return sizeMB_; }
+
+private:
+    // 16バイト
+    struct Entry
+    {
+        std::atomic<Key> keyXorNodes{0};
+        std::atomic<std::uint64_t> nodes{0};
+    };
+
+    static Key entryKey(Key key, int depth);
+
+    std::unique_ptr<Entry[]> entries_;
+    std::size_t entryCount_ = 0; // 2のべき乗
+    std::size_t sizeMB_ = 0;
+};
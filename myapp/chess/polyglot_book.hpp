@@ -0,0 +1,80 @@
+#pragma once
+
+//+++
+// Polyglot 形式 (.bin) のオープニングブック
+// ・ファイルはメモリマップして読むだけ (開く時にファイル全体を読み込まない)
+// ・エントリは16バイト (キー8・指し手2・重み2・学習値4、ビッグエンディアン) でキー順に
+//   並んでいるので、局面のキーで二分探索する (1回の参照は数マイクロ秒以内)
+// ・キーの作り方 (駒・キャスリング・アンパサン・手番への乱数の割り当て) は Polyglot と同じ
+//   乱数表は Polyglot 標準の Random64 (781個) をそのまま持つので、他のプログラムで作ったブックも引ける
+// ・開いた後は読むだけなので、複数スレッドから同時に引いてよい
+//+++
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "mapped_file.hpp"
+#include "zobrist.hpp"
+
+// ブック1件分 (ファイル上の値をデコードしたもの)
+struct BookEntry
+{
+    Key key = 0;
+    std::uint16_t move = 0;   // Polyglot の指し手 (decodeMove で変換する)
+    std::uint16_t weight = 0; // 選ぶ割合 (大きいほどよく指す)
+    std::uint32_t learn = 0;  // 学習値 (使わない)
+};
+
+// ブックの使い方
+struct BookOptions
+{
+    int minWeight = 1;      // これより軽い手は指さない
+    int maxPly = 30;        // 開始局面からこの手数 (片方の手で数える) までブックを引く
+    bool bestOnly = false;  // true なら最も重い手だけを指す (false なら重みに比例してランダム)
+    bool bankTime = true;   // ブックで浮いた思考時間を、ブックを抜けた後の手に回す
+};
+
+class PolyglotBook
+{
+public:
+    static constexpr int RANDOM_COUNT = 781; // 駒 12x64 + キャスリング 4 + アンパサン 8 + 手番 1
+
+    // 初期局面のキー (Polyglot の仕様書の例、乱数表の確認用)
+    static constexpr Key STANDARD_START_KEY = 0x463B96181691FC9CULL;
+
+    PolyglotBook() = default;
+    PolyglotBook(const PolyglotBook &) = delete;
+    PolyglotBook &operator=(const PolyglotBook &) = delete;
+
+    // ブックを開く (開いていたものは閉じる)
+    // サイズが16バイトの倍数でなければ false を返す
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const { return file_.isOpen(); }
+    const std::string &path() const { return path_; }
+    std::size_t entryCount() const { return count_; }
+
+    // 局面のキー
+    // mailbox: マス -> 駒コード (NO_PIECE = 空マス)
+    // castling: キャスリング権 (bit0 = 白キングサイド, bit1 = 白クイーンサイド, bit2/3 = 黒)
+    // epFile: アンパサンで取れるポーンの列 (-1 = なし)
+    static Key key(const int mailbox[64], int castling, int epFile, bool whiteToMove);
+
+    // key の手の範囲 [first, last) を返す (無ければ first == last)
+    void find(Key key, std::size_t &first, std::size_t &last) const;
+    BookEntry entry(std::size_t index) const;
+
+    // Polyglot の指し手 <-> マス (makeSquare の番号) と昇格する駒種 (昇格しなければ NO_PIECE_TYPE)
+    // キャスリングは「キングがルークのマスへ動く手」として書かれている
+    static void decodeMove(std::uint16_t move, int &from, int &to, int &promotion);
+    static std::uint16_t encodeMove(int from, int to, int promotion);
+
+    static constexpr int NO_PIECE_TYPE = -1;
+
+private:
+    MappedFile file_;
+    const unsigned char *data_ = nullptr;
+    std::size_t count_ = 0; // エントリ数
+    std::string path_;
+};
@@ -0,0 +1,176 @@
+#pragma once
+
+//+++
+// 駒の価値と位置価値テーブル (Piece-Square Tables: PSTs)
+// ・序中盤 (mg) と終盤 (eg) の値を1つの Score に詰めて持ち、評価時に局面の進み具合で補間する
+//   (終盤かどうかで値を切り替えると、境目で評価値が跳んで探索が無駄に揺れるため)
+// ・PSQT[駒コード][マス] は白黒両方の駒について、駒の価値 + 位置的価値をコンパイル時に作った表
+//   (白はプラス、黒は盤面を上下反転してマイナス) なので、駒1つにつき表引き1回で済む
+//+++
+
+#include <cstdint>
+
+#include "bitboard.hpp"
+
+// -------------------------------------------------------------
+// 序中盤と終盤の値の組 (Score)
+// -------------------------------------------------------------
+
+// 下位32bitに序中盤、上位32bitに終盤の値を入れる (キングの価値が16bitに収まらないため64bit)
+// 足し引きは普通の整数のまま両方の値に効く
+using Score = std::int64_t;
+
+constexpr Score makeScore(int mg, int eg)
+{
+    return Score(std::uint64_t(std::int64_t(eg)) << 32) + mg;
+}
+
+constexpr int mgValue(Score s)
+{
+    return int(std::int32_t(std::uint32_t(std::uint64_t(s))));
+}
+
+// 下位の値が負なら上位から1借りているので、0x80000000 を足して戻す
+constexpr int egValue(Score s)
+{
+    return int(std::int32_t(std::uint32_t((std::uint64_t(s) + 0x80000000ULL) >> 32)));
+}
+
+// -------------------------------------------------------------
+// 局面の進み具合 (ポーン以外の駒の量: 初期局面で PHASE_MAX、駒が減るほど0に近づく)
+// -------------------------------------------------------------
+
+constexpr int PhaseWeight[6] = {0, 1, 1, 2, 4, 0}; // P, N, B, R, Q, K
+constexpr int PHASE_MAX = 24;
+
+// mg と eg を phase (0 〜 PHASE_MAX) で補間する
+constexpr int taper(Score s, int phase)
+{
+    return (mgValue(s) * phase + egValue(s) * (PHASE_MAX - phase)) / PHASE_MAX;
+}
+
+// -------------------------------------------------------------
+// 位置価値テーブル (白から見た配置、[0] が8段目)
+// ポーン・ナイト・ビショップ・ルーク・クイーンは序中盤と終盤で同じ値を使う
+// -------------------------------------------------------------
+
+// ポーン：中央支配と積極的な前進を評価
+constexpr int PawnTable[8][8] = {
+    {0, 0, 0, 0, 0, 0, 0, 0},                        // 8段目 (プロモーション)
+    {80, 80, 80, 80, 80, 80, 80, 80},                // 7段目 (プロモーション間近: +80)
+    {50, 50, 60, 50, 50, 60, 50, 40},                // 6段目 (ポーン前進を強く奨励)
+    {40, 40, 30, 60, 60, 30, 20, 20},                // 5段目
+    {30, 30, 40, 60, 60, 40, 30, 30},                // 4段目
+    {0, 0, 30, 10, 10, 30, 0, 0},                    // 3段目 (中央ポーンに僅かなボーナス)
+    {-20, -20, -20, -30, -30, -20, -20, -20},        // 2段目 (初期位置のポーンにペナルティ)
+    {-100, -100, -100, -100, -100, -100, -100, -100} // 1段目 (あり得ない)
+};
+
+constexpr int KnightTable[8][8] = {
+    {-50, -40, -30, -30, -30, -30, -40, -50},
+    {-40, -20, 0, 5, 5, 0, -20, -40},
+    {-30, 5, 5, 5, 5, 5, 5, -30},
+    {-30, 0, 10, 10, 10, 10, 0, -30},
+    {-30, 5, 10, 10, 10, 10, 5, -30},
+    {-30, 0, 5, 5, 5, 5, 0, -30},
+    {-40, -20, 0, 0, 0, 0, -20, -40},
+    {-30, -10, -10, -10, -10, -10, -10, -30}};
+
+// ビショップ: 中央向きを評価
+constexpr int BishopTable[8][8] = {
+    {-20, -10, -10, -10, -10, -10, -10, -20},
+    {-10, 0, 0, 0, 0, 0, 0, -10},
+    {-10, 0, 5, 10, 10, 5, 0, -10},
+    {-10, 5, 10, 15, 15, 10, 5, -10}, // 中央(d4, e4)の斜線上に +15 のボーナス
+    {-10, 0, 10, 15, 15, 10, 0, -10},
+    {-10, 5, 5, 10, 10, 5, 5, -10},
+    {-10, 0, 0, 0, 0, 0, 0, -10},
+    {-20, -10, -10, -10, -10, -10, -10, -20}};
+
+// ルーク: 7段目/オープンファイルを評価
+constexpr int RookTable[8][8] = {
+    {0, 0, 0, 5, 5, 0, 0, 0},
+    {-5, 0, 0, 0, 0, 0, 0, -5},
+    {-5, 0, 0, 0, 0, 0, 0, -5},
+    {-5, 0, 0, 0, 0, 0, 0, -5},
+    {-5, 0, 0, 0, 0, 0, 0, -5},
+    {-5, 0, 0, 0, 0, 0, 0, -5},
+    {5, 10, 10, 10, 10, 10, 10, 5}, // 7段目ルークは高得点
+    {0, 0, 0, 0, 0, 0, 0, 0}};
+
+// クイーン: 中央を評価
+constexpr int QueenTable[8][8] = {
+    {-20, -10, -10, -5, -5, -10, -10, -20},
+    {-10, 0, 0, 0, 0, 0, 0, -10},
+    {-10, 0, 5, 5, 5, 5, 0, -10},
+    {-5, 0, 5, 5, 5, 5, 0, -5},
+    {0, 0, 5, 5, 5, 5, 0, -5},
+    {-10, 5, 5, 5, 5, 5, 0, -10},
+    {-10, 0, 5, 0, 0, 0, 0, -10},
+    {-20, -10, -10, -5, -5, -10, -10, -20}};
+
+// キング (ミドルゲーム):
+constexpr int KingTable[8][8] = {
+    // 序中盤の評価: 隅に高いボーナス
+    {-30, -40, -40, -50, -50, -40, -40, -30},
+    {-30, -40, -40, -50, -50, -40, -40, -30},
+    {-30, -40, -40, -50, -50, -40, -40, -30},
+    {-30, -40, -40, -50, -50, -40, -40, -30},
+    {-20, -30, -30, -40, -40, -30, -30, -20},
+    {-10, -20, -20, -20, -20, -20, -20, -10},
+    {20, 20, 0, 0, 0, 0, 20, 20}, // 2段目のキングは少し安全
+    {20, 30, 10, 0, 0, 10, 30, 20}};
+
+// キング (エンドゲーム): 中央に出て駒の戦いに加わる
+constexpr int KingEndgameTable[8][8] = {
+    {-50, -30, -30, -30, -30, -30, -30, -50},
+    {-30, -10, 0, 0, 0, 0, -10, -30},
+    {-30, 0, 20, 30, 30, 20, 0, -30},
+    {-30, 0, 30, 40, 40, 30, 0, -30},
+    {-30, 0, 30, 40, 40, 30, 0, -30},
+    {-30, 0, 20, 30, 30, 20, 0, -30},
+    {-30, -10, 0, 0, 0, 0, -10, -30},
+    {-50, -30, -30, -30, -30, -30, -30, -50}};
+
+constexpr const int (*MgTables[6])[8] = {PawnTable, KnightTable, BishopTable, RookTable, QueenTable, KingTable};
+constexpr const int (*EgTables[6])[8] = {PawnTable, KnightTable, BishopTable, RookTable, QueenTable, KingEndgameTable};
+
+// 駒の物質的価値 (P:200, N/B:300, R:500, Q:900, K:10000000)
+constexpr int PieceValues[6] = {200, 300, 300, 500, 900, 10000000};
+
+// -------------------------------------------------------------
+// 駒コード x マス -> 駒の価値 + 位置的価値 (コンパイル時に作る)
+// -------------------------------------------------------------
+
+struct PsqTable
+{
+    Score values[12][64];
+
+    constexpr const Score *operator[](int piece) const { return values[piece]; }
+};
+
+constexpr PsqTable makePsqTable()
+{
+    PsqTable table{};
+    for (int color = WHITE; color <= BLACK; color++)
+    {
+        int sign = (color == WHITE) ? 1 : -1;
+        for (int type = PAWN; type <= KING; type++)
+        {
+            for (int sq = 0; sq < 64; sq++)
+            {
+                // 黒の駒は盤面を上下反転して (7-r, c) を使う
+                int row = (color == WHITE) ? rowOf(sq) : (7 - rowOf(sq));
+                int mg = PieceValues[type] + MgTables[type][row][colOf(sq)];
+                int eg = PieceValues[type] + EgTables[type][row][colOf(sq)];
+                table.values[makePiece(color, type)][sq] = makeScore(sign * mg, sign * eg);
+            }
+        }
+    }
+    return table;
+}
+
+inline constexpr PsqTable PSQT = makePsqTable();
+
+static_assert(mgValue(PSQT[makePiece(BLACK, KING)][6]) == -(10000000 + 30), "black king on g8 (mg)");
+static_assert(egValue(PSQT[makePiece(BLACK, PAWN)][8]) == -(200 - 20), "black pawn on a7 (eg)");
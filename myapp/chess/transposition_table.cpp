@@ -0,0 +1,186 @@
+#include "transposition_table.hpp"
+
+#include <climits>
+
+// -------------------------------------------------------------
+// data (64bit) の並び
+//   bit  0-31 : 評価値 (int32)
+//   bit 32-47 : 最善手 (PackedMove::raw())
+//   bit 48-55 : 残り深さ
+//   bit 56-57 : Bound (0 = 空きエントリ)
+//   bit 58-63 : 探索世代
+// -------------------------------------------------------------
+
+static std::uint64_t packData(int score, std::uint16_t move, int depth, Bound bound, std::uint8_t generation)
+{
+    return std::uint64_t(std::uint32_t(score)) |
+           (std::uint64_t(move) << 32) |
+           (std::uint64_t(std::uint8_t(depth)) << 48) |
+           (std::uint64_t(bound) << 56) |
+           (std::uint64_t(generation & 63) << 58);
+}
+
+static int dataScore(std::uint64_t d) { return int(std::int32_t(std::uint32_t(d))); }
+static std::uint16_t dataMove(std::uint64_t d) { return std::uint16_t(d >> 32); }
+static int dataDepth(std::uint64_t d) { return int((d >> 48) & 0xFF); }
+static Bound dataBound(std::uint64_t d) { return Bound((d >> 56) & 3); }
+static int dataGeneration(std::uint64_t d) { return int(d >> 58); }
+
+// メイトのスコアは「ルートからの手数」を「このノードからの手数」に直して保存する
+// (同じ局面が別の手数で現れても正しいメイト距離になるように)
+static int scoreToTT(int score, int ply)
+{
+    if (score >= MATE_IN_MAX_PLY)
+        return score + ply;
+    if (score <= -MATE_IN_MAX_PLY)
+        return score - ply;
+    return score;
+}
+
+static int scoreFromTT(int score, int ply)
+{
+    if (score >= MATE_IN_MAX_PLY)
+        return score - ply;
+    if (score <= -MATE_IN_MAX_PLY)
+        return score + ply;
+    return score;
+}
+
+// -------------------------------------------------------------
+// TranspositionTable
+// -------------------------------------------------------------
+
+TranspositionTable::TranspositionTable(std::size_t sizeMB)
+{
+    resize(sizeMB);
+}
+
+void TranspositionTable::resize(std::size_t sizeMB)
+{
+    sizeMB_ = sizeMB;
+    std::size_t count = sizeMB * 1024 * 1024 / sizeof(Bucket);
+    bucketCount_ = count > 0 ? count : 1;
+    buckets_.reset(new Bucket[bucketCount_]);
+    generation_ = 0;
+}
+
+void TranspositionTable::clear()
+{
+    for (std::size_t i = 0; i < bucketCount_; i++)
+    {
+        for (Entry &e : buckets_[i].entries)
+        {
+            e.keyXorData.store(0, std::memory_order_relaxed);
+            e.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    generation_ = 0;
+}
+
+void TranspositionTable::newSearch()
+{
+    generation_ = (generation_ + 1) & 63;
+}
+
+TranspositionTable::Bucket &TranspositionTable::bucketFor(Key key)
+{
+    // キーの上位ビットで 0 〜 バケット数-1 に写す (2のべき乗でなくてもよい)
+    return buckets_[std::size_t((unsigned __int128)key * bucketCount_ >> 64)];
+}
+
+const TranspositionTable::Bucket &TranspositionTable::bucketFor(Key key) const
+{
+    return buckets_[std::size_t((unsigned __int128)key * bucketCount_ >> 64)];
+}
+
+bool TranspositionTable::probe(Key key, int ply, TTData &data, Stats &stats)
+{
+    stats.probes++;
+    for (const Entry &e : bucketFor(key).entries)
+    {
+        std::uint64_t d = e.data.load(std::memory_order_relaxed);
+        if (dataBound(d) != BOUND_NONE && (e.keyXorData.load(std::memory_order_relaxed) ^ d) == key)
+        {
+            stats.hits++;
+            data.score = scoreFromTT(dataScore(d), ply);
+            data.depth = dataDepth(d);
+            data.bound = dataBound(d);
+            data.move = dataMove(d);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(Key key, int ply, int score, int depth, Bound bound, std::uint16_t move, Stats &stats)
+{
+    Bucket &bucket = bucketFor(key);
+    Entry *replace = nullptr;
+    int worstValue = INT_MAX;
+    int generation = generation_.load(std::memory_order_relaxed);
+
+    for (Entry &e : bucket.entries)
+    {
+        std::uint64_t d = e.data.load(std::memory_order_relaxed);
+
+        // 同じ局面のエントリ
+        if (dataBound(d) != BOUND_NONE && (e.keyXorData.load(std::memory_order_relaxed) ^ d) == key)
+        {
+            // 今回の探索で得たより深い結果は、浅い境界値では上書きしない
+            if (bound != BOUND_EXACT && dataGeneration(d) == generation && depth < dataDepth(d))
+                return;
+            // 最善手が無い場合は以前の最善手を残す
+            if (move == 0)
+                move = dataMove(d);
+            replace = &e;
+            worstValue = INT_MIN;
+            break;
+        }
+
+        // 空きエントリが最優先、次に「浅い + 古い」エントリ
+        int value = (dataBound(d) == BOUND_NONE)
+                        ? INT_MIN + 1
+                        : dataDepth(d) - 8 * ((generation - dataGeneration(d)) & 63);
+        if (value < worstValue)
+        {
+            worstValue = value;
+            replace = &e;
+        }
+    }
+
+    if (worstValue != INT_MIN && worstValue != INT_MIN + 1)
+        stats.collisions++;
+    stats.stores++;
+
+    std::uint64_t d = packData(scoreToTT(score, ply), move, depth, bound, std::uint8_t(generation));
+    replace->keyXorData.store(key ^ d, std::memory_order_relaxed);
+    replace->data.store(d, std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const
+{
+    std::size_t count = bucketCount_ < 1000 ? bucketCount_ : 1000;
+    int generation = generation_.load(std::memory_order_relaxed);
+    int used = 0;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        for (const Entry &e : buckets_[i].entries)
+        {
+            std::uint64_t d = e.data.load(std::memory_order_relaxed);
+            if (dataBound(d) != BOUND_NONE && dataGeneration(d) == generation)
+                used++;
+        }
+    }
+    return int(used * 1000 / (count * BUCKET_SIZE));
+}
+
+std::uint16_t TranspositionTable::bestMove(Key key) const
+{
+    for (const Entry &e : bucketFor(key).entries)
+    {
+        std::uint64_t d = e.data.load(std::memory_order_relaxed);
+        if (dataBound(d) != BOUND_NONE && (e.keyXorData.load(std::memory_order_relaxed) ^ d) == key)
+            return dataMove(d);
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+//+++
+// 置換表 (Transposition Table)
+// ・探索済みの局面の評価値・最善手をZobristキーで引けるように保存する
+// ・1バケット = 4エントリ (64バイト = キャッシュライン1本)
+// ・置き換えは深さ優先 (古い探索世代のエントリは優先的に置き換える)
+// ・複数スレッドから同時に読み書きしてよい (ロックなし)
+//   キーとデータをXORして保存するので、書き込みが混ざったエントリは読み出し時に弾かれる
+//+++
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <cstdint>
+
+#include "types.hpp"
+#include "zobrist.hpp"
+
+// 評価値の種類 (alpha-beta の窓に対してどうだったか)
+enum Bound : std::uint8_t
+{
+    BOUND_NONE = 0,
+    BOUND_UPPER = 1, // 真の値はこれ以下 (fail-low)
+    BOUND_LOWER = 2, // 真の値はこれ以上 (fail-high)
+    BOUND_EXACT = 3
+};
+
+// 置換表から読み出した内容
+struct TTData
+{
+    int score;           // 評価値 (メイトのスコアはこのノードからの手数に直したもの)
+    int depth;           // 探索した残り深さ
+    Bound bound;
+    std::uint16_t move;  // 最善手 (PackedMove::raw()、0 = なし)
+};
+
+class TranspositionTable
+{
+public:
+    // 統計 (表のサイズを決めるための目安)
+    // 表の側では持たず、探索スレッドごとに呼び出し側が持って probe/store に渡す
+    // (全スレッドで同じカウンタに書くとキャッシュラインの取り合いになるため)
+    struct Stats
+    {
+        std::uint64_t probes = 0;     // 参照回数
+        std::uint64_t hits = 0;       // キーが一致した回数
+        std::uint64_t stores = 0;     // 書き込み回数
+        std::uint64_t collisions = 0; // 別の局面のエントリを追い出した回数
+
+        Stats &operator+=(const Stats &other)
+        {
+            probes += other.probes;
+            hits += other.hits;
+            stores += other.stores;
+            collisions += other.collisions;
+            return *this;
+        }
+    };
+
+    explicit TranspositionTable(std::size_t sizeMB);
+
+    void resize(std::size_t sizeMB);
+    void clear();
+
+    // 探索ごとに世代を進める (古いエントリを置き換えやすくする)
+    void newSearch();
+
+    // stats に参照・書き込みの回数を数える
+    bool probe(Key key, int ply, TTData &data, Stats &stats);
+    void store(Key key, int ply, int score, int depth, Bound bound, std::uint16_t move, Stats &stats);
+
+    // 最善手だけを読む (統計には数えない、最善手順の表示用、0 = なし)
+    std::uint16_t bestMove(Key key) const;
+
+    std::size_t sizeMB() const { return sizeMB_; }
+
+    // 使用率 (1000分率、先頭1000バケットから概算)
+    int hashfull() const;
+
+private:
+    // キーとデータをXORして保存し、キーの検証に使う (16バイト)
+    struct Entry
+    {
+        std::atomic<Key> keyXorData{0};
+        std::atomic<std::uint64_t> data{0};
+    };
+
+    static constexpr int BUCKET_SIZE = 4;
+
+    struct alignas(64) Bucket
+    {
+        Entry entries[BUCKET_SIZE];
+    };
+
+    Bucket &bucketFor(Key key);
+    const Bucket &bucketFor(Key key) const;
+
+    std::unique_ptr<Bucket[]> buckets_;
+    std::size_t bucketCount_ = 0;
+    std::size_t sizeMB_ = 0;
+    std::atomic<std::uint8_t> generation_{0};
+};
@@ -18,4 +18,13 @@ struct Piece {
 
 
 // 移動を表す型エイリアス
-using Move = std::pair<std::pair<int,int>, std::pair<int,int>>;
\ No newline at end of file
+using Move = std::pair<std::pair<int,int>, std::pair<int,int>>;
+
+// 「手が無い」ことを表す値 (移動元 == 移動先)
+const Move MOVE_NONE = {{0, 0}, {0, 0}};
+
+// 探索で使う評価値の定数 (白から見た値)
+constexpr int INF_SCORE = 1000000000;
+constexpr int MATE_SCORE = 999999000;               // チェックメイト (ルートからの手数だけ小さくする)
+constexpr int MATE_IN_MAX_PLY = MATE_SCORE - 1000;  // 絶対値がこれ以上ならメイトのスコア
+constexpr int MAX_PLY = 64;                         // 反復深化で探索する最大の深さ
@@ -0,0 +1,35 @@
+#include "zobrist.hpp"
+
+namespace Zobrist
+{
+    Key psq[12][64];
+    Key side;
+    Key castling[16];
+
+    // 固定の種による疑似乱数 (xorshift64*)、毎回同じキーになる
+    static Key nextRand(Key &state)
+    {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 2685821657736338717ULL;
+    }
+
+    static bool buildKeys()
+    {
+        Key state = 1070372ULL;
+        for (auto &piece : psq)
+            for (Key &k : piece)
+                k = nextRand(state);
+        side = nextRand(state);
+        for (Key &k : castling)
+            k = nextRand(state);
+        return true;
+    }
+
+    void init()
+    {
+        static const bool initialized = buildKeys();
+        (void)initialized;
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+//+++
+// Zobristハッシュ
+// ・駒とマスの組み合わせ、手番、キャスリング権ごとに乱数を割り当て、
+//   局面のキーはそれらのXORで表す
+// ・指し手ごとに変化した部分だけXORし直せばよい (差分更新)
+//+++
+
+#include <cstdint>
+
+using Key = std::uint64_t;
+
+namespace Zobrist
+{
+    // 起動時に一度だけ呼ぶ (ChessGameのコンストラクタから呼ばれる)
+    void init();
+
+    extern Key psq[12][64];   // [駒コード][マス]
+    extern Key side;          // 黒番のときにXORする
+    extern Key castling[16];  // キャスリング権 (4bit) ごと
+}
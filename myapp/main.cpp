@@ -22,6 +22,13 @@ int main(int argc, char *argv[])
     // 1. ChessGame クラスのインスタンスを作成 (ロジック)
     ChessGame game;
 
+    // オープニングブックがあれば使う (無ければ序盤から探索する)
+    if (game.openBook("book.bin"))
+        qDebug() << "Opening book loaded:" << game.book()->entryCount() << "entries";
+    // 3駒の終盤のビットベース (chess-tools の bitbase_gen で作ったもの)
+    if (int n = game.loadBitbases("bitbases"))
+        qDebug() << "Endgame bitbases loaded:" << n << "files";
+
     // // 2. SerialManager のインスタンスを作成 (通信・デバイス)
     // SerialManager serialManager(DEV_NAME);
 
@@ -80,7 +80,7 @@ void MainWindow::setupUI()
     m_autocalib_button = new QPushButton("自動キャリブレーション");
 
     // 初期FEN設定 (元の main.cpp から移動)
-    QString startFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR";
+    QString startFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
     m_fenInput->setText(startFEN);
 
     // レイアウトの設定
@@ -233,45 +233,16 @@ void MainWindow::on_autocalib_button_clicked()
 
 void MainWindow::on_moveinput_button_clicked()
 {
-    const QString &text = m_fenInput->text();
     const QString &movetext = m_moveInput->text();
 
-    std::string newBoard[8];
-    QStringList ranks = text.split('/');
-
-    // FEN形式ではないと判断した場合は処理を中断
-    if (ranks.size() != 8)
+    // 1. ChessGameに状態を設定 (FEN形式ではないと判断した場合は処理を中断)
+    if (!loadFen(m_fenInput->text()))
         return;
 
-    for (int i = 0; i < 8; ++i)
-    {
-        QString rank = ranks[i];
-        std::string row_str = "";
-
-        for (QChar pieceChar : rank)
-        {
-            if (pieceChar.isDigit())
-            {
-                int emptyCount = pieceChar.digitValue();
-                for (int k = 0; k < emptyCount; ++k)
-                {
-                    row_str += '*';
-                }
-            }
-            else
-            {
-                row_str += pieceChar.toLatin1();
-            }
-        }
-        newBoard[i] = row_str;
-    }
-
+    std::string newBoard[8];
+    m_game->getBoardAsStrings(newBoard);
     m_boardWidget->setBoardState(newBoard);
 
-    // 2. ChessGameに状態を設定
-    m_game->initBoardWithStrings(newBoard);
-    // bool turnWhite = true; // 仮に白番として処理 (FENから読み取るべき情報だが、元のコードに合わせて暫定的に固定)
-
     Move thismove;
     std::string moveAlg = movetext.toStdString();
     if (m_game->algebraicToMove(moveAlg, thismove))
@@ -307,24 +278,10 @@ void MainWindow::on_moveinput_button_clicked()
         // processAITurn();
     }
 
-    std::string nowRows[8];
-    m_game->getBoardAsStrings(nowRows);
-
-    std::string myfen = "";
-
-    for (int i = 0; i < 8; ++i)
-    {
-        // 最初の要素 (i == 0) の場合は区切り文字を追加しない
-        if (i > 0)
-        {
-            myfen += "/"; // i > 0 の場合に区切り文字を追加
-        }
-
-        // 現在の行の文字列を追加
-        myfen += nowRows[i];
-    }
-
-    m_fenInput->setText(QString::fromStdString(myfen));
+    // 指した後の局面をFENで書き戻す (手番・キャスリング権・アンパサンのマス・手数も引き継ぐ)
+    FenBuffer buffer;
+    std::string_view myfen = m_game->fen(buffer);
+    m_fenInput->setText(QString::fromLatin1(myfen.data(), int(myfen.size())));
 
     // m_boardWidget->setBoardState(nowRows);
     processAITurn();
@@ -338,46 +295,17 @@ void MainWindow::on_moveinput_button_clicked()
 // FEN文字列を受け取り、合法手と最善手を生成し、boardWidgetを更新する
 void MainWindow::on_fenInput_textChanged(const QString &text)
 {
-    std::string newBoard[8];
-    QStringList ranks = text.split('/');
-
-    // FEN形式ではないと判断した場合は処理を中断
-    if (ranks.size() != 8)
+    // 1. ChessGameに状態を設定 (FEN形式ではないと判断した場合は処理を中断)
+    if (!loadFen(text))
         return;
 
-    for (int i = 0; i < 8; ++i)
-    {
-        QString rank = ranks[i];
-        std::string row_str = "";
-
-        for (QChar pieceChar : rank)
-        {
-            if (pieceChar.isDigit())
-            {
-                int emptyCount = pieceChar.digitValue();
-                for (int k = 0; k < emptyCount; ++k)
-                {
-                    row_str += '*';
-                }
-            }
-            else
-            {
-                row_str += pieceChar.toLatin1();
-            }
-        }
-        newBoard[i] = row_str;
-    }
-
-    // 1. GUI (描画ウィジェット)を更新
+    // 2. GUI (描画ウィジェット)を更新
+    std::string newBoard[8];
+    m_game->getBoardAsStrings(newBoard);
     m_boardWidget->setBoardState(newBoard);
 
-    // 2. ChessGameに状態を設定
-    m_game->initBoardWithStrings(newBoard);
-    // bool turnWhite = m_game->turn; // 仮に白番として処理 (FENから読み取るべき情報だが、元のコードに合わせて暫定的に固定)
-
-    // 3. 合法手と最善手を生成
+    // 3. 合法手を生成 (最善手は別スレッドで探索し、終わったらラベルを更新する)
     std::vector<Move> legalMoves = m_game->generateMoves(m_turnWhite);
-    Move best = m_game->bestMove(m_turnWhite);
 
     // 4. GUI表示用の文字列に変換
     QStringList moveStrings;
@@ -388,26 +316,103 @@ void MainWindow::on_fenInput_textChanged(const QString &text)
         moveStrings.append(QString::fromStdString(start_alg + end_alg));
     }
 
-    QString bestString;
-    std::string start_alg = m_game->coordsToAlgebraic(best.first.first, best.first.second);
-    std::string end_alg = m_game->coordsToAlgebraic(best.second.first, best.second.second);
-    bestString = QString::fromStdString(start_alg + end_alg);
-
-    std::string mycommand = command(newBoard, best);
-
-    QString commandString = QString::fromStdString(mycommand);
-
     // 5. ラベルを更新
     QString prefix;
 
     prefix = QString("Legal Moves (") + (m_turnWhite ? "White" : "Black") + "): ";
     m_moveListLabel->setText(prefix + moveStrings.join(", "));
 
-    prefix = QString("Best Move (") + (m_turnWhite ? "White" : "Black") + "): ";
-    m_bestMoveLabel->setText(prefix + bestString);
+    // 先読み中は解析を始めない (置換表とCPUを取り合い、ラベルも上書きしてしまう)
+    // AIが指した直後の局面なら先読みの途中経過 (startPondering) を表示したままにし、予想どおりの応手なら processAITurn に任せる
+    if (m_ponder.valid())
+    {
+        FenBuffer buffer;
+        std::string_view fen = m_game->fen(buffer);
+        if (fen == m_ponderRootFen || fen == m_ponderFen)
+            return;
+        stopPondering(); // 局面が変わったので予想は外れた
+    }
+
+    startAnalysis(std::vector<std::string>(newBoard, newBoard + 8));
+}
 
-    prefix = QString("Command for Arduino: \n");
-    m_commandLabel->setText(prefix + commandString);
+// FEN文字列で m_game の局面を設定し、手番を合わせる (盤面だけの文字列は白番として読む)
+// FEN として読めなければ何も変えずに false を返す
+bool MainWindow::loadFen(const QString &text)
+{
+    QByteArray latin = text.toLatin1();
+    if (!m_game->setFen(std::string_view(latin.constData(), std::size_t(latin.size()))))
+        return false;
+    m_turnWhite = m_game->sideToMoveIsWhite();
+    return true;
+}
+
+// 候補手1つ分の表示 ("1. e2e4  +35  e2e4 e7e5 g1f3")
+// 評価値は白から見た値、メイトは "#3" (白の勝ち) / "#-3" (黒の勝ち)
+static QString formatAnalysisLine(int rank, int score, int mateIn, const std::vector<std::string> &pv)
+{
+    QString value = mateIn != 0 ? QString("#%1").arg(mateIn) : (score > 0 ? "+" : "") + QString::number(score);
+    QStringList moves;
+    for (const std::string &m : pv)
+        moves.append(QString::fromStdString(m));
+    QString first = moves.isEmpty() ? QString("-") : moves[0];
+    return QString("%1. %2  %3  %4").arg(rank).arg(first).arg(value).arg(moves.join(" "));
+}
+
+// 盤面 board の上位 ANALYSIS_LINES 個の候補手を別スレッドで探索し、途中経過と結果をラベルに表示する
+void MainWindow::startAnalysis(const std::vector<std::string> &board)
+{
+    int id = ++m_searchId;
+    bool turnWhite = m_turnWhite;
+    QString prefix = QString("Best Move (") + (turnWhite ? "White" : "Black") + "): ";
+    m_bestMoveLabel->setText(prefix + "thinking...");
+    m_analysisLines.clear();
+
+    SearchLimits limits = m_game->searchLimits();
+    limits.multiPv = ANALYSIS_LINES;
+
+    SearchCallbacks callbacks;
+    callbacks.onInfo = [this, id, prefix](const SearchInfo &info)
+    {
+        // 深さごとに1番目の候補手から順に届くので、その番号の行を置き換える
+        int index = info.multiPv - 1;
+        QString line = formatAnalysisLine(info.multiPv, info.score, info.mateIn, info.pv) +
+                       QString("  (depth %1)").arg(info.depth);
+        QMetaObject::invokeMethod(this, [this, id, prefix, index, line]()
+                                  {
+                                      if (id != m_searchId)
+                                          return;
+                                      while (m_analysisLines.size() <= index)
+                                          m_analysisLines.append(QString());
+                                      m_analysisLines[index] = line;
+                                      m_bestMoveLabel->setText(prefix + "thinking...\n" + m_analysisLines.join("\n"));
+                                  },
+                                  Qt::QueuedConnection);
+    };
+    callbacks.onDone = [this, id, prefix, board](const Move &best, const SearchStats &stats)
+    {
+        QStringList lines;
+        for (std::size_t i = 0; i < stats.lines.size(); i++)
+            lines.append(formatAnalysisLine(int(i) + 1, stats.lines[i].score, stats.lines[i].mateIn, stats.lines[i].pv));
+        QMetaObject::invokeMethod(this, [this, id, prefix, board, best, lines]()
+                                  {
+                                      if (id != m_searchId)
+                                          return;
+                                      std::string rows[8];
+                                      std::copy(board.begin(), board.end(), rows);
+                                      std::string bestString = m_game->moveToAlgebratic(best);
+                                      m_analysisLines = lines;
+                                      QString text = prefix + QString::fromStdString(bestString);
+                                      if (!lines.isEmpty())
+                                          text += "\n" + lines.join("\n");
+                                      m_bestMoveLabel->setText(text);
+                                      m_commandLabel->setText(QString("Command for Arduino: \n") +
+                                                              QString::fromStdString(command(rows, best)));
+                                  },
+                                  Qt::QueuedConnection);
+    };
+
+    m_search = m_game->startSearch(turnWhite, limits, callbacks);
 }
 
 void MainWindow::handleSerialError(const QString &message)
@@ -470,60 +475,145 @@ void MainWindow::processAITurn()
     if (m_turnWhite || m_fenInput->text().isEmpty())
         return;
 
-    // 現在の盤面を m_game に確実に設定し直す（FEN解析ロジックを再利用）
-    const QString &text = m_fenInput->text();
-    std::string newBoard[8];
-    QStringList ranks = text.split('/');
-    if (ranks.size() != 8)
+    // 現在の盤面を m_game に確実に設定し直す
+    if (!loadFen(m_fenInput->text()))
         return;
 
-    for (int i = 0; i < 8; ++i)
+    // 1. AIの手を別スレッドで探索する (指すのは applyAIMove で)
+    //    書き出し直した FEN を渡すので、空白の違いなどがあっても先読みした局面と比べられる
+    FenBuffer fen;
+    startAITurn(std::string(m_game->fen(fen)));
+}
+
+void MainWindow::startAITurn(const std::string &fen)
+{
+    int id = ++m_searchId;
+
+    // ★ 先読みが当たった (人が予想どおりに指した) なら、新しく探索せずに先読みの結果を使う
+    //   思考時間は先読みを始めた時から数えるので、人が考えていた時間が長ければすぐに指せる
+    QString ai = QString("AI (") + (m_turnWhite ? "White" : "Black") + ")";
+    if (m_ponder.valid() && fen == m_ponderFen)
     {
-        QString rank = ranks[i];
-        std::string row_str = "";
-        for (QChar pieceChar : rank)
+        m_search = SearchHandle(); // 人の手番に始めた解析は止める
+        m_bestMoveLabel->setText(ai + " is thinking... (ponder hit)");
+        m_ponderHit = true;
+        if (m_ponder.ready())
         {
-            if (pieceChar.isDigit())
-            {
-                int emptyCount = pieceChar.digitValue();
-                for (int k = 0; k < emptyCount; ++k)
-                {
-                    row_str += '*';
-                }
-            }
-            else
-            {
-                row_str += pieceChar.toLatin1();
-            }
+            m_ponderHit = false;
+            applyAIMove(fen, m_ponder.get(), m_ponder.stats().ponderMove);
         }
-        newBoard[i] = row_str;
+        else
+        {
+            m_ponder.ponderHit(); // 終わったら startPondering の通知で指す
+        }
+        return;
     }
-    m_game->initBoardWithStrings(newBoard);
 
-    // 1. AIの手を打つ
-    Move best = m_game->bestMove(m_turnWhite);
+    // 予想が外れたので先読みは止める (置換表には読んだ結果が残る)
+    stopPondering();
+    m_bestMoveLabel->setText(ai + " is thinking...");
+
+    SearchCallbacks callbacks;
+    callbacks.onDone = [this, id, fen](const Move &best, const SearchStats &stats)
+    {
+        QMetaObject::invokeMethod(this, [this, id, fen, best, ponderMove = stats.ponderMove]()
+                                  {
+                                      if (id == m_searchId)
+                                          applyAIMove(fen, best, ponderMove);
+                                  },
+                                  Qt::QueuedConnection);
+    };
+
+    m_search = m_game->startSearch(m_turnWhite, m_game->searchLimits(), callbacks);
+}
+
+// AIが指した後の局面 fen で、人の応手 ponderMove を指した局面を先読みする
+// 人が指すまでは時間で止めずに読み続ける
+void MainWindow::startPondering(const std::string &fen, Move ponderMove)
+{
+    stopPondering();
+
+    m_game->setFen(fen);
+    bool humanWhite = m_game->sideToMoveIsWhite();
+    if (ponderMove == MOVE_NONE || !m_game->isLegal(ponderMove, humanWhite))
+        return;
+
+    QString expected = QString::fromStdString(m_game->moveToAlgebratic(ponderMove));
+    m_game->makeMove(ponderMove);
+    FenBuffer predicted;
+    m_ponderFen.assign(m_game->fen(predicted));
+    m_ponderRootFen = fen;
+
+    int id = m_ponderId;
+    SearchLimits limits = m_game->searchLimits();
+    limits.ponder = true;
+
+    // 人の手番の間は、解析の代わりに先読みの途中経過を表示する
+    QString prefix = QString("AI (") + (humanWhite ? "Black" : "White") + ") is pondering on " + expected + "...\n";
+    m_bestMoveLabel->setText(prefix);
+
+    SearchCallbacks callbacks;
+    callbacks.onInfo = [this, id, prefix](const SearchInfo &info)
+    {
+        QString line = formatAnalysisLine(1, info.score, info.mateIn, info.pv) + QString("  (depth %1)").arg(info.depth);
+        QMetaObject::invokeMethod(this, [this, id, prefix, line]()
+                                  {
+                                      // 予想どおりに指された後は startAITurn の表示のままにする
+                                      if (id == m_ponderId && !m_ponderHit)
+                                          m_bestMoveLabel->setText(prefix + line);
+                                  },
+                                  Qt::QueuedConnection);
+    };
+    callbacks.onDone = [this, id](const Move &best, const SearchStats &stats)
+    {
+        QMetaObject::invokeMethod(this, [this, id, best, ponderMove = stats.ponderMove]()
+                                  {
+                                      // 人が予想どおりに指す前に読み終わった場合は、指されるまで結果を取っておく
+                                      if (id != m_ponderId || !m_ponderHit)
+                                          return;
+                                      m_ponderHit = false;
+                                      std::string fen = m_ponderFen; // applyAIMove で先読みを止めると消えるのでコピーする
+                                      applyAIMove(fen, best, ponderMove);
+                                  },
+                                  Qt::QueuedConnection);
+    };
+    m_ponder = m_game->startSearch(!humanWhite, limits, callbacks);
+
+    // 探索は盤面をコピーして行うので、こちらの盤面は元に戻しておく
+    m_game->setFen(fen);
+}
+
+void MainWindow::stopPondering()
+{
+    ++m_ponderId; // 止めた先読みの結果は捨てる
+    m_ponderHit = false;
+    m_ponder = SearchHandle(); // 止めて終わるまで待つ (数ミリ秒)
+    m_ponderFen.clear();
+    m_ponderRootFen.clear();
+}
+
+// 探索が終わったAIの手を指す (GUIスレッド)
+void MainWindow::applyAIMove(const std::string &fen, Move best, Move ponderMove)
+{
+    std::string newBoard[8];
+    m_game->setFen(fen);
+    m_game->getBoardAsStrings(newBoard);
     m_game->makeMove(best);
-    m_turnWhite = true; // ターンを白に戻す
+    m_turnWhite = m_game->sideToMoveIsWhite(); // ターンを人に戻す
 
     // 2. シリアルコマンド生成（AIの手を打つ前の盤面 newBoard と最善手 best を使用）
     std::string mycommand = command(newBoard, best);
 
     // 3. 新しい盤面状態をFENに変換 (AIが動かした後)
-    std::string nowRows[8];
-    m_game->getBoardAsStrings(nowRows);
-    std::string myfen = "";
-    for (int i = 0; i < 8; ++i)
-    {
-        if (i > 0)
-        {
-            myfen += "/";
-        }
-        myfen += nowRows[i];
-    }
+    FenBuffer buffer;
+    std::string myfen(m_game->fen(buffer));
+
+    // 4. 人が考えている間に、予想した応手の後の局面を先読みする
+    startPondering(myfen, ponderMove);
 
-    // 4. GUIを更新: FEN更新 -> on_fenInput_textChanged が呼ばれ、ラベルとボードが自動更新される
+    // 5. GUIを更新: FEN更新 -> on_fenInput_textChanged が呼ばれ、ラベルとボードが自動更新される
     m_fenInput->setText(QString::fromStdString(myfen));
 
-    // 5. シリアルコマンドをワーカースレッドに委譲
+    // 6. シリアルコマンドをワーカースレッドに委譲
     emit sendAiCommand(QString::fromStdString(mycommand));
 }
@@ -9,10 +9,12 @@
 #include <QPushButton>
 #include <QLabel>
 #include <QLineEdit>
+#include <QStringList>
 #include <vector>
 #include <string>
 
 #include "route/route.hpp"
+#include "chess/chess_game.hpp" // SearchHandle (非同期探索)
 
 // 依存するクラスの前方宣言
 // SerialManager クラスは後で作成するものとして、ここでは仮に ChessGame のみ宣言
@@ -79,6 +81,30 @@ private:
     void setupUI();
     void setupConnections();
 
+    // 最善手の探索は別スレッドで行い、結果はGUIスレッドで受け取る
+    // 局面は FEN で受け渡す (手番・キャスリング権・手数も失わない)
+    bool loadFen(const QString &text);
+    void startAnalysis(const std::vector<std::string> &board);
+    void startAITurn(const std::string &fen);
+    void applyAIMove(const std::string &fen, Move best, Move ponderMove = MOVE_NONE);
+
+    SearchHandle m_search; // 実行中の探索 (新しい探索を始めると前の探索は止まる)
+    int m_searchId = 0;    // 古い探索からの通知を捨てるための番号
+
+    // 解析表示: 上位の候補手を評価値と手順つきで並べる (multi-PV)
+    static constexpr int ANALYSIS_LINES = 3;
+    QStringList m_analysisLines; // 候補手ごとの表示 (最善手が先頭)
+
+    // 先読み (ponder): AIが指した後、人が考えている間に予想した応手の後の局面を読んでおく
+    void startPondering(const std::string &fen, Move ponderMove);
+    void stopPondering();
+
+    SearchHandle m_ponder;                  // 先読みの探索 (予想が外れたらすぐ止める)
+    std::string m_ponderFen;                // 先読みしている局面 (予想した応手を指した後)
+    std::string m_ponderRootFen;            // 先読みを始めた局面 (AIが指した後、人の手番)
+    int m_ponderId = 0;                     // 止めた先読みからの通知を捨てるための番号
+    bool m_ponderHit = false;               // 人が予想どおりに指したので、先読みが終わったらその手を指す
+
     // グローバル変数の代わりに、モーター状態を管理するローカル変数
     bool m_moter_isON = false;
     bool m_turnWhite = true;